@@ -3,6 +3,9 @@
 #include "StringFunc.h"
 #include "stepdef.h"
 
+#include <algorithm>
+#include <climits>
+
 // 反转义字符对应
 static const std::map<char, char> s_EscapeBackItemMap{
     {'\\', '\\'}, {'a', '='}, {'b', '&'}, {'n', '\n'}};
@@ -11,6 +14,24 @@ static const std::map<char, char> s_EscapeBackItemMap{
 static const std::map<char, char> s_EscapeItemMap{
     {'\\', '\\'}, {'=', 'a'}, {'&', 'b'}, {'\n', 'n'}};
 
+// 单条记录的预期长度，记录不会超过第三档
+static size_t RecordSizeHint(size_t avgBytes)
+{
+    return std::min(avgBytes, static_cast<size_t>(CachedPBStep::CacheBlockSizeTier3));
+}
+
+// 缓存池预留的总长度，截断到int范围内，并留出一个结点的余量使Reserve累加时不溢出
+static int CacheReserveSize(size_t count, size_t avgBytes)
+{
+    const size_t limit = INT_MAX - CachedPBStep::CacheBlockSizeTier3;
+    avgBytes = RecordSizeHint(avgBytes);
+    if (avgBytes != 0 && count > limit / avgBytes)
+    {
+        return static_cast<int>(limit);
+    }
+    return static_cast<int>(count * avgBytes);
+}
+
 CachedPBStep::CachedPBStep(int blockSize)
     : blockSize_(blockSize), cachePoolPtr_(new pobo::ReuseCacheList(blockSize))
 {
@@ -31,6 +52,42 @@ void CachedPBStep::Init()
     tmpBuffer_.clear();
 
     currentRecIndex_ = -1;
+    expectedOutputSize_ = 0;
+}
+
+WarmUpReport CachedPBStep::WarmUp(const WarmUpProfile &profile)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    Init();
+    bodyRecords_.reserve(profile.records);
+    // 临时缓存存放单条记录，留出一倍余量应对记录长度波动
+    tmpBuffer_.reserve(RecordSizeHint(profile.avgRecordBytes) * 2);
+
+    CheckAndExpandCache(RecordSizeHint(profile.avgRecordBytes));
+
+    WarmUpReport report;
+    report.objects = 1;
+    report.reservedBytes = cachePoolPtr_->Reserve(CacheReserveSize(profile.records, profile.avgRecordBytes));
+    report.elapsedUs = warmup::ElapsedUs(begin);
+    return report;
+}
+
+void CachedPBStep::ExpectRecords(size_t count, size_t avgBytes)
+{
+    if (count == 0 || avgBytes == 0)
+    {
+        return;
+    }
+
+    bodyRecords_.reserve(count);
+    tmpBuffer_.reserve(RecordSizeHint(avgBytes) * 2);
+
+    CheckAndExpandCache(RecordSizeHint(avgBytes));
+    cachePoolPtr_->Reserve(CacheReserveSize(count, avgBytes));
+
+    // 序列化时每条记录后跟一个换行
+    expectedOutputSize_ = count * (avgBytes + 1);
 }
 
 bool CachedPBStep::SetPackage(const std::string &src)
@@ -58,6 +115,7 @@ bool CachedPBStep::SetPackage(const std::string &src)
             currBuf.push_back('&'); // 补位
         }
 
+        CheckAndExpandCache(currBuf.size());
         char *cachePtr = cachePoolPtr_->PushBack(currBuf.data(), currBuf.size());
 
         bodyRecords_.emplace_back(std::make_pair(cachePtr, currBuf.size()));
@@ -91,13 +149,15 @@ void CachedPBStep::ParseBaseRecord(const std::string &baseStr)
 
 std::string CachedPBStep::ToString()
 {
-    std::string result;
-    if (!bodyRecords_.empty())
+    std::string result = BaseRecord();
+    if (expectedOutputSize_ > 0)
     {
-        result.reserve(bodyRecords_.size() * bodyRecords_.front().second + 1024);
+        result.reserve(result.size() + expectedOutputSize_);
+    }
+    else if (!bodyRecords_.empty())
+    {
+        result.reserve(result.size() + bodyRecords_.size() * (bodyRecords_.front().second + 1));
     }
-
-    result = BaseRecord();
 
     for (auto &item : bodyRecords_)
     {
@@ -166,20 +226,14 @@ void CachedPBStep::EndAppendRecord()
         return;
     }
 
-    // 首先尝试将数据存储到当前缓存池
+    // 超过当前档位时先升档，需要新结点时直接按新档位分配，只分配一次
+    CheckAndExpandCache(tmpBuffer_.size());
+
     char *ptr = cachePoolPtr_->PushBack(tmpBuffer_.data(), tmpBuffer_.size());
     if (ptr == nullptr)
     {
-        // 当前缓存池空间不足，尝试扩容
-        CheckAndExpandCache(tmpBuffer_.size());
-
-        // 扩容后再次尝试存储
-        ptr = cachePoolPtr_->PushBack(tmpBuffer_.data(), tmpBuffer_.size());
-        if (ptr == nullptr)
-        {
-            // 扩容后仍然无法存储，抛出异常
-            throw std::runtime_error("[CachedPBStep]CachePool size is not enough to store data after expansion.");
-        }
+        // 扩容后仍然无法存储，抛出异常
+        throw std::runtime_error("[CachedPBStep]CachePool size is not enough to store data after expansion.");
     }
 
     bodyRecords_.back().first = ptr;
@@ -466,49 +520,20 @@ void CachedPBStep::CheckAndExpandCache(size_t requiredSize)
         return; // 当前block size足够，无需扩容
     }
 
-    // 尝试扩容到下一档
-    int nextTierSize = GetNextTierBlockSize(blockSize_);
-    if (nextTierSize == -1)
-    {
-        // 已经是第三档或无法扩容，抛出异常
-        throw std::runtime_error("[CachedPBStep]Required size " + std::to_string(requiredSize) +
-                               " exceeds maximum cache block size " + std::to_string(CacheBlockSizeTier3));
-    }
-
-    // 扩容到下一档：保存现有数据，重建缓存池
-    int oldBlockSize = blockSize_;
-
-    // 临时保存所有现有记录的数据
-    std::vector<std::string> savedRecords;
-    for (const auto& record : bodyRecords_)
+    // 直接升到能容纳该数据的档位
+    int nextTierSize = blockSize_;
+    while (requiredSize > static_cast<size_t>(nextTierSize))
     {
-        if (record.first != nullptr && record.second > 0)
+        nextTierSize = GetNextTierBlockSize(nextTierSize);
+        if (nextTierSize == -1)
         {
-            savedRecords.emplace_back(std::string(record.first, record.second));
+            // 已经是第三档或无法扩容，抛出异常
+            throw std::runtime_error("[CachedPBStep]Required size " + std::to_string(requiredSize) +
+                                   " exceeds maximum cache block size " + std::to_string(CacheBlockSizeTier3));
         }
     }
 
-    // 更新block size
+    // 升档只影响之后新分配的结点：新结点接在链表尾部，已有记录原地保留，无需拷贝
     blockSize_ = nextTierSize;
-
-    // 重建缓存池：删除旧的，创建新的
-    delete cachePoolPtr_;
-    cachePoolPtr_ = new pobo::ReuseCacheList(blockSize_);
-
-    // 重新添加所有保存的记录
-    bodyRecords_.clear();
-    for (const auto& recordData : savedRecords)
-    {
-        char* ptr = cachePoolPtr_->PushBack(recordData.data(), recordData.size());
-        if (ptr == nullptr)
-        {
-            // 重建失败，回滚并抛出异常
-            blockSize_ = oldBlockSize;
-            delete cachePoolPtr_;
-            cachePoolPtr_ = new pobo::ReuseCacheList(blockSize_);
-            bodyRecords_.clear();
-            throw std::runtime_error("[CachedPBStep]Failed to rebuild cache pool during expansion");
-        }
-        bodyRecords_.emplace_back(std::make_pair(ptr, recordData.size()));
-    }
+    cachePoolPtr_->SetBlockSize(blockSize_);
 }
\ No newline at end of file
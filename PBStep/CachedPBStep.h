@@ -9,6 +9,7 @@
 #pragma once
 
 #include "ReuseCacheList.h"
+#include "WarmUp.h"
 
 #include <string>
 #include <map>
@@ -59,6 +60,19 @@ public:
 
     void Init();
 
+    /**
+     * @brief 启动预热：按预期负载预留缓存池、记录索引和临时缓存
+     * 记录平均长度超过当前档位时直接升档，会清空当前数据
+     */
+    WarmUpReport WarmUp(const WarmUpProfile &profile);
+
+    /**
+     * @brief 已知记录数时给出容量提示，一次性预留记录索引、缓存池和输出缓存
+     * @param count 预期记录数
+     * @param avgBytes 单条记录的平均字节数
+     */
+    void ExpectRecords(size_t count, size_t avgBytes);
+
     /*对于字符的转义，需要注意：
      * 1. 存入内存中的数据必须是转义过的数据，否则内存中的数据无法被正确查找
      * 2. 从内存中查找Get到的数据，需要做反转义的操作，才是准确的数据
@@ -130,7 +144,7 @@ protected:
     // 不带转义
     std::string GetItem(int stepid);
 
-    // 检查并扩容缓存
+    // 检查并扩容缓存：升到能容纳requiredSize的档位，之后新分配的结点使用新档位
     void CheckAndExpandCache(size_t requiredSize);
 
     // 获取下一档的block size
@@ -159,4 +173,7 @@ protected:
      * 2) 通过AddFieldValue添加记录时，作为临时缓存，每添加完一条记录，就会清空该缓存来准备下一条记录的添加。这种情况，该字段不适用于查询
      */
     std::string tmpBuffer_;
+
+    // 预期的包体序列化长度，ToString据此预留输出缓存，0表示未知
+    size_t expectedOutputSize_ = 0;
 };
\ No newline at end of file
@@ -87,8 +87,8 @@ namespace pobo
             m_pCacheCurrent = m_pCacheCurrent->GetNext();
         }
 
-        // 最后的结点空间已经用完，分配一个新的结点
-        CacheNode *pNode = new CacheNode(m_nDataBlockSize);
+        // 最后的结点空间已经用完，分配一个新的结点，数据超过结点长度时按数据长度分配
+        CacheNode *pNode = new CacheNode(nDataLen > m_nDataBlockSize ? nDataLen : m_nDataBlockSize);
 
         ++m_nCapacity;
 
@@ -110,6 +110,27 @@ namespace pobo
         m_pCacheCurrent = m_pCacheHead;
     }
 
+    int ReuseCacheList::Reserve(int nTotalLen)
+    {
+        int nTotalSize = 0;
+        for (CacheNode *pNode = m_pCacheHead; pNode != nullptr; pNode = pNode->GetNext())
+        {
+            nTotalSize += pNode->BufSize();
+        }
+
+        while (nTotalSize < nTotalLen)
+        {
+            CacheNode *pNode = new CacheNode(m_nDataBlockSize);
+            ++m_nCapacity;
+
+            m_pCacheTail->SetNext(pNode);
+            m_pCacheTail = pNode;
+            nTotalSize += m_nDataBlockSize;
+        }
+
+        return nTotalSize;
+    }
+
     void ReuseCacheList::PopFront(int len)
     {
         m_pCacheCurrent->PopFront(len);
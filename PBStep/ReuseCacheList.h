@@ -56,6 +56,11 @@ namespace pobo
             return m_nLength;
         }
 
+        int BufSize() const
+        {
+            return m_nBufSize;
+        }
+
     private:
         int m_nBufSize;     /**< 缓冲区长度 */
         char *m_pBuffer;    /**< 缓冲区指针 */
@@ -92,6 +97,7 @@ namespace pobo
         void PopFront(int len);
 
         /**向队列尾部加入一块数据
+         * 已有结点都放不下时分配一个新结点，数据超过结点长度时新结点按数据长度分配
          * @param pData 加入数据的指针
          * @param nDataLen 加入数据的长度
          * @return 加入缓冲区的地址
@@ -107,9 +113,32 @@ namespace pobo
          */
         void Reset();
 
+        /**调整后续新增结点的长度，已有结点及其中的数据保持不变
+         * 链表中因此可以混有不同长度的结点
+         * @param nDataBlockSize 新结点可存贮数据的长度
+         */
+        void SetBlockSize(int nDataBlockSize)
+        {
+            m_nDataBlockSize = nDataBlockSize;
+        }
+
+        /**预留缓存，保证所有结点的总容量不少于nTotalLen
+         * 结点内存在分配时已清零，即已完成预取
+         * @param nTotalLen 预期需要缓存的总长度
+         * @return 预留后所有结点的总容量
+         */
+        int Reserve(int nTotalLen);
+
+        /**总结点个数
+         */
+        int Capacity() const
+        {
+            return m_nCapacity;
+        }
+
     private:
         int m_nCapacity = 1;      // 总节点个数
-        int m_nDataBlockSize = 0; /**< 每个结点可存贮数据的长度*/
+        int m_nDataBlockSize = 0; /**< 新分配结点可存贮数据的长度*/
 
         CacheNode *m_pCacheHead;    /**< 头结点 */
         CacheNode *m_pCacheCurrent; /**< 当前结点 */
@@ -0,0 +1,290 @@
+#pragma once
+
+/**
+ * @brief 多记录数据的统一实现
+ * 记录的存储方式(StoragePolicy)和字段的格式化方式(FormatPolicy)在编译期确定，
+ * 添加字段、结束记录等热路径上没有虚函数调用
+ * 具体的存储方式见 MultiRecordStream.h、MultiRecordStreamWithPool.h、
+ * MultiRecordStreamWithMem.h、MultiRecordStreamWithArena.h 中的类型别名
+ */
+
+#include "StreamBase.h"
+#include "FieldIndex.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+namespace step
+{
+    /**
+     * @brief STEP格式：字段为 id=value& ，记录之间以'\n'分隔
+     */
+    struct StepFormatPolicy
+    {
+        static void AppendField(std::string &out, int stepid, const char *value, size_t len)
+        {
+            fmt::format_int id(stepid);
+            out.append(id.data(), id.size());
+            out.push_back('=');
+            out.append(value, len);
+            out.push_back('&');
+        }
+
+        static void EndRecord(std::string &out)
+        {
+            out.push_back('\n');
+        }
+    };
+
+    /**
+     * @brief 以整条记录为单位存储的策略基类(CRTP)
+     * 字段先格式化到临时缓存，记录结束时整条交给 Derived::PushRecord 存储
+     * Derived 需要实现:
+     *   void PushRecord(const char *data, size_t len);
+     *   template <class Fn> void ForEach(Fn &&fn) const; // fn(const char *data, size_t len)
+     */
+    template <class Derived>
+    class RecordBufferStorage
+    {
+    public:
+        template <class Format>
+        void AddField(int stepid, const char *value, size_t len)
+        {
+            Format::AppendField(m_TmpBuffer, stepid, value, len);
+        }
+
+        template <class Format>
+        void EndRecord()
+        {
+            static_cast<Derived *>(this)->PushRecord(m_TmpBuffer.data(), m_TmpBuffer.size());
+            m_TmpBuffer.clear();
+        }
+
+        template <class Format>
+        void Serialize(std::string &out) const
+        {
+            static_cast<const Derived *>(this)->ForEach([&out](const char *data, size_t len)
+                                                        {
+                                                            out.append(data, len);
+                                                            Format::EndRecord(out);
+                                                        });
+        }
+
+    protected:
+        // 临时缓存存放单条记录，留出一倍余量应对记录长度波动
+        void ReserveRecordBuffer(size_t avgBytes) { m_TmpBuffer.reserve(avgBytes * 2); }
+        void ClearRecordBuffer() { m_TmpBuffer.clear(); }
+
+    private:
+        std::string m_TmpBuffer;
+    };
+
+    /**
+     * @brief 多记录数据，一般用于应答数据
+     * StoragePolicy 需要实现:
+     *   void Clear();
+     *   void Reserve(size_t count, size_t avgBytes);
+     *   void PushRecord(const char *data, size_t len); // 存入一条已格式化的记录(反序列化使用)
+     *   std::pair<const char *, size_t> FindField(size_t rec, int stepid) const;
+     *   void IndexFields(); // 为已存入的记录建立字段查找所需的索引
+     *   template <class Format> void AddField(int stepid, const char *value, size_t len);
+     *   template <class Format> void EndRecord();
+     *   template <class Format> void Serialize(std::string &out) const;
+     *   size_t Count() const;    // 记录条数
+     *   size_t DataSize() const; // 已格式化记录的总长度(不含换行)，未知时返回0
+     */
+    template <class StoragePolicy, class FormatPolicy = StepFormatPolicy>
+    class BasicMultiRecordStream : public StreamBase
+    {
+    public:
+        using Storage = StoragePolicy;
+        using Format = FormatPolicy;
+
+        BasicMultiRecordStream() = default;
+        ~BasicMultiRecordStream() = default;
+
+        virtual void Init() override
+        {
+            m_Storage.Clear();
+            m_Pending = false;
+            m_ExpectedSize = 0;
+        }
+
+        /**
+         * @brief 反序列化
+         * 每条记录只拷贝一次存入存储策略，随后一次建立所有记录的字段位置索引，
+         * 之后的 GetFieldRaw / GetFieldValue 不修改对象，多个线程可并发读取；
+         * 值保持转义状态，读取时按需反转义
+         */
+        virtual bool DoDeserialize(const std::string &src) override
+        {
+            if (src.empty())
+            {
+                return false;
+            }
+
+            Init();
+            m_BaseRecords.clear();
+
+            size_t baseEnd = src.find('\n');
+            ParseBaseRecord(src.substr(0, baseEnd));
+            if (baseEnd == std::string::npos)
+            {
+                return true;
+            }
+
+            const char *pos = src.data() + baseEnd + 1;
+            const char *end = src.data() + src.size();
+            if (pos < end)
+            {
+                size_t lines = std::count(pos, end, '\n') + 1;
+                m_Storage.Reserve(lines, (end - pos) / lines);
+            }
+
+            while (pos < end)
+            {
+                const char *lineEnd = static_cast<const char *>(::memchr(pos, '\n', end - pos));
+                if (lineEnd == nullptr)
+                {
+                    lineEnd = end;
+                }
+
+                if (lineEnd > pos)
+                {
+                    m_Storage.PushRecord(pos, lineEnd - pos);
+                }
+                pos = lineEnd + 1;
+            }
+
+            m_Storage.IndexFields();
+            return true;
+        }
+
+        // 序列化
+        virtual std::string ToSerialized() override
+        {
+            std::string result = BaseRecord();
+            // 每条记录后跟一个换行
+            size_t bodySize = m_Storage.DataSize() + m_Storage.Count();
+            result.reserve(result.size() + std::max(m_ExpectedSize, bodySize));
+
+            m_Storage.template Serialize<Format>(result);
+            return result;
+        }
+
+        virtual void ExpectRecords(size_t count, size_t avgBytes) override
+        {
+            StreamBase::ExpectRecords(count, avgBytes);
+            m_Storage.Reserve(count, avgBytes);
+        }
+
+        void AppendRecord()
+        {
+            if (m_Pending)
+            {
+                // should not here
+                EndAppendRecord();
+            }
+        }
+
+        // 结束当条记录的添加
+        void EndAppendRecord()
+        {
+            m_Storage.template EndRecord<Format>();
+            m_Pending = false;
+        }
+
+        // 添加记录
+        void AddFieldValue(int stepid, const std::string &value, bool isEscape = false)
+        {
+            if (isEscape)
+            {
+                std::string escaped = EscapeItem(value);
+                AddRawValue(stepid, escaped.data(), escaped.size());
+            }
+            else
+            {
+                AddRawValue(stepid, value.data(), value.size());
+            }
+        }
+
+        void AddFieldValue(int stepid, const char *value, bool isEscape = false)
+        {
+            if (value == nullptr)
+            {
+                AddRawValue(stepid, "", 0);
+            }
+            else if (isEscape)
+            {
+                AddFieldValue(stepid, std::string(value), true);
+            }
+            else
+            {
+                AddRawValue(stepid, value, ::strlen(value));
+            }
+        }
+
+        void AddFieldValue(int stepid, char value)
+        {
+            AddRawValue(stepid, &value, value == '\0' ? 0 : 1);
+        }
+
+        template <typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value>::type
+        AddFieldValue(int stepid, T value)
+        {
+            fmt::memory_buffer buffer;
+            fmt::format_to(std::back_inserter(buffer), "{}", value);
+            AddRawValue(stepid, buffer.data(), buffer.size());
+        }
+
+        size_t RecordsCount() const
+        {
+            return m_Storage.Count();
+        }
+
+        /* 获取第rec条记录的字段，返回转义状态的原始数据，不拷贝；未找到返回 {nullptr, 0}
+         * 反序列化后可多线程并发读取；之后添加了记录时，首次读取新记录会补建索引，不能与其他读取并发
+         */
+        std::pair<const char *, size_t> GetFieldRaw(size_t rec, int stepid) const
+        {
+            return m_Storage.FindField(rec, stepid);
+        }
+
+        // 获取第rec条记录的字段值，仅在含转义字符时反转义
+        std::string GetFieldValue(size_t rec, int stepid) const
+        {
+            auto raw = GetFieldRaw(rec, stepid);
+            if (raw.first == nullptr)
+            {
+                return std::string();
+            }
+
+            std::string value(raw.first, raw.second);
+            if (::memchr(raw.first, '\\', raw.second) != nullptr)
+            {
+                return EscapeBackItem(value);
+            }
+            return value;
+        }
+
+        Storage &GetStorage() { return m_Storage; }
+        const Storage &GetStorage() const { return m_Storage; }
+
+    private:
+        // 添加已转义的字段值
+        void AddRawValue(int stepid, const char *value, size_t len)
+        {
+            m_Storage.template AddField<Format>(stepid, value, len);
+            m_Pending = true;
+        }
+
+    private:
+        Storage m_Storage;
+
+        // 当前记录是否已添加字段但尚未结束
+        bool m_Pending = false;
+    };
+}
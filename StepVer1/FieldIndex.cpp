@@ -0,0 +1,36 @@
+#include "FieldIndex.h"
+
+using namespace step;
+
+void FieldIndex::Clear()
+{
+    m_Entries.clear();
+    m_RecordBegins.resize(1);
+}
+
+void FieldIndex::AddRecord(const char *data, size_t len)
+{
+    ForEachField(data, len, [this, data](int stepid, const char *value, size_t valueLen)
+                 { m_Entries.push_back(Entry{stepid, static_cast<uint32_t>(value - data), static_cast<uint32_t>(valueLen)}); });
+
+    m_RecordBegins.push_back(static_cast<uint32_t>(m_Entries.size()));
+}
+
+bool FieldIndex::Find(size_t rec, int stepid, size_t &offset, size_t &length) const
+{
+    if (rec >= RecordCount())
+    {
+        return false;
+    }
+
+    for (uint32_t i = m_RecordBegins[rec]; i < m_RecordBegins[rec + 1]; ++i)
+    {
+        if (m_Entries[i].stepid == stepid)
+        {
+            offset = m_Entries[i].offset;
+            length = m_Entries[i].length;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+/**
+ * @brief 记录 id=value&id=value& 的字段位置索引
+ * 只保存字段在记录中的偏移和长度，不拷贝数据，值保持转义状态
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace step
+{
+    /**
+     * @brief 逐个解析记录中的字段，不分配内存
+     * @param fn 回调 fn(int stepid, const char *value, size_t len)，value为转义后的原始数据
+     */
+    template <class Fn>
+    void ForEachField(const char *data, size_t len, Fn &&fn)
+    {
+        const char *pos = data;
+        const char *end = data + len;
+        while (pos < end)
+        {
+            int stepid = 0;
+            bool negative = (*pos == '-');
+            if (negative)
+            {
+                ++pos;
+            }
+            while (pos < end && *pos >= '0' && *pos <= '9')
+            {
+                stepid = stepid * 10 + (*pos - '0');
+                ++pos;
+            }
+
+            if (pos >= end || *pos != '=')
+            {
+                return; // 格式错误，停止解析
+            }
+
+            const char *value = ++pos;
+            while (pos < end && *pos != '&')
+            {
+                ++pos;
+            }
+
+            fn(negative ? -stepid : stepid, value, static_cast<size_t>(pos - value));
+            ++pos; // 跳过'&'
+        }
+    }
+
+    class FieldIndex
+    {
+    public:
+        void Clear();
+
+        // 解析一条记录并追加其字段索引
+        void AddRecord(const char *data, size_t len);
+
+        // 已建立索引的记录条数
+        size_t RecordCount() const { return m_RecordBegins.size() - 1; }
+
+        /**
+         * @brief 在第rec条记录中查找字段
+         * @param offset 输出：值在记录中的偏移
+         * @param length 输出：值的长度
+         * @return 未建立索引或未找到返回false
+         */
+        bool Find(size_t rec, int stepid, size_t &offset, size_t &length) const;
+
+    private:
+        struct Entry
+        {
+            int stepid;
+            uint32_t offset;
+            uint32_t length;
+        };
+        std::vector<Entry> m_Entries;
+
+        // 第i条记录的字段为 m_Entries[m_RecordBegins[i], m_RecordBegins[i + 1])
+        std::vector<uint32_t> m_RecordBegins{0};
+    };
+
+    /**
+     * @brief 为以整条文本存储记录的策略提供按字段查找(CRTP)
+     * Derived 需要实现 std::pair<const char *, size_t> Record(size_t i) const 和 Count()
+     * 反序列化结束时通过 IndexFields 为所有记录建立索引，之后的查找只读索引，多个线程可并发查找；
+     * 之后再添加的记录在首次查找时才补建索引，这次查找会修改索引，不能与其他查找并发
+     */
+    template <class Derived>
+    class TextRecordLookup
+    {
+    public:
+        std::pair<const char *, size_t> FindField(size_t rec, int stepid) const
+        {
+            const Derived *self = static_cast<const Derived *>(this);
+            if (rec >= self->Count())
+            {
+                return std::make_pair(nullptr, 0);
+            }
+
+            if (m_FieldIndex.RecordCount() <= rec)
+            {
+                IndexRecords(rec + 1);
+            }
+
+            size_t offset = 0;
+            size_t length = 0;
+            if (!m_FieldIndex.Find(rec, stepid, offset, length))
+            {
+                return std::make_pair(nullptr, 0);
+            }
+            return std::make_pair(self->Record(rec).first + offset, length);
+        }
+
+        // 为尚未建立索引的记录建立字段索引
+        void IndexFields()
+        {
+            IndexRecords(static_cast<const Derived *>(this)->Count());
+        }
+
+    protected:
+        void ClearFieldIndex() { m_FieldIndex.Clear(); }
+
+    private:
+        // 为前count条记录建立索引
+        void IndexRecords(size_t count) const
+        {
+            const Derived *self = static_cast<const Derived *>(this);
+            while (m_FieldIndex.RecordCount() < count)
+            {
+                auto record = self->Record(m_FieldIndex.RecordCount());
+                m_FieldIndex.AddRecord(record.first, record.second);
+            }
+        }
+
+    private:
+        mutable FieldIndex m_FieldIndex;
+    };
+}
@@ -1,56 +1,39 @@
 #include "MultiRecordStream.h"
-#include "StringFunc.h"
 
 using namespace step;
 
-void MultiRecordStream::Init()
+void MapStorage::Clear()
 {
     m_Records.clear();
+    m_CurrRecord.clear();
 }
 
-std::string MultiRecordStream::ToSerialized()
+void MapStorage::PushRecord(const char *data, size_t len)
 {
-    std::string result = BaseRecord();
+    std::map<int, std::string> record;
+    ForEachField(data, len, [&record](int stepid, const char *value, size_t valueLen)
+                 { record.emplace(stepid, std::string(value, valueLen)); });
 
-    for (auto &record : m_Records)
-    {
-        for (auto &item : record)
-        {
-            result.append(fmt::format("{}={}\n", item.first, item.second));
-        }
-
-        result.push_back('\n');
-    }
-
-    return result;
+    m_Records.emplace_back(std::move(record));
 }
 
-void MultiRecordStream::AppendRecord()
+std::pair<const char *, size_t> MapStorage::FindField(size_t rec, int stepid) const
 {
-    if (!m_CurrRecord.empty())
+    if (rec >= m_Records.size())
     {
-        m_Records.emplace_back(std::move(m_CurrRecord));
-        m_CurrRecord.clear();
+        return std::make_pair(nullptr, 0);
     }
 
-    return;
-}
-
-void MultiRecordStream::EndAppendRecord()
-{
-    m_Records.emplace_back(std::move(m_CurrRecord));
+    auto it = m_Records[rec].find(stepid);
+    if (it == m_Records[rec].end())
+    {
+        return std::make_pair(nullptr, 0);
+    }
+    return std::make_pair(it->second.data(), it->second.size());
 }
 
-/*
-void MultiRecordStream::AddFieldValue(int stepid, std::string &&value, bool isEscape)
+void MapStorage::Reserve(size_t count, size_t avgBytes)
 {
-    if (isEscape)
-    {
-        m_CurrRecord.emplace(stepid, EscapeItem(std::forward<std::string>(value)));
-    }
-    else
-    {
-        m_CurrRecord.emplace(stepid, std::forward<std::string>(value));
-    }
+    (void)avgBytes;
+    m_Records.reserve(count);
 }
-*/
\ No newline at end of file
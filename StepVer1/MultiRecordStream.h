@@ -1,62 +1,73 @@
 #pragma once
 
 /**
- * @brief 多记录数据
+ * @brief 多记录数据，每条记录存为 map<stepid, value>
  * 一般用于应答数据
  */
 
-#include "StreamBase.h"
+#include "BasicMultiRecordStream.h"
 
-#include <list>
-#include <deque>
+#include <map>
 #include <vector>
 
 namespace step
 {
     using RecordsType = std::vector<std::map<int, std::string>>;
-    class MultiRecordStream : public StreamBase
+
+    /**
+     * @brief 存储策略：vector<map>，序列化时才格式化字段
+     * 同一条记录中重复添加的stepid保留第一次的值
+     */
+    class MapStorage
     {
     public:
-        MultiRecordStream() = default;
-        ~MultiRecordStream() = default;
-
-        virtual void Init() override;
-
-        // 序列化
-        virtual std::string ToSerialized() override;
+        void Clear();
+        void Reserve(size_t count, size_t avgBytes);
 
-        virtual bool DoDeserialize(const std::string &src)
+        template <class Format>
+        void AddField(int stepid, const char *value, size_t len)
         {
-            return true;
+            m_CurrRecord.emplace(stepid, std::string(value, len));
         }
 
-        void AppendRecord();
-        // 结束当条记录的添加
-        void EndAppendRecord();
-
-        // 添加记录
-        template <char>
-        void AddFiledValue(int stepid, char value)
+        template <class Format>
+        void EndRecord()
         {
-            m_CurrRecord.emplace(stepid, value == '\0' ? "" : std::string(1, value));
+            m_Records.emplace_back(std::move(m_CurrRecord));
+            m_CurrRecord.clear();
         }
 
-        template <typename T>
-        void AddFieldValue(int stepid, T &&value)
+        // 解析一条已格式化的记录，值保持转义状态
+        void PushRecord(const char *data, size_t len);
+
+        std::pair<const char *, size_t> FindField(size_t rec, int stepid) const;
+        // 字段已按map存放，无需另建索引
+        void IndexFields() {}
+
+        template <class Format>
+        void Serialize(std::string &out) const
         {
-            if constexpr (std::is_arithmetic<T>::value) // 数字类型
+            for (const auto &record : m_Records)
             {
-                m_CurrRecord.emplace(stepid, std::to_string(value));
-            }
-            else
-            {
-                m_CurrRecord.emplace(stepid, std::forward<T>(value));
+                for (const auto &item : record)
+                {
+                    Format::AppendField(out, item.first, item.second.data(), item.second.size());
+                }
+                Format::EndRecord(out);
             }
         }
 
+        size_t Count() const { return m_Records.size(); }
+        // 字段在序列化时才格式化，长度未知
+        size_t DataSize() const { return 0; }
+
+        const RecordsType &Records() const { return m_Records; }
+
     private:
         RecordsType m_Records;
 
         std::map<int, std::string> m_CurrRecord;
     };
-}
\ No newline at end of file
+
+    using MultiRecordStream = BasicMultiRecordStream<MapStorage>;
+}
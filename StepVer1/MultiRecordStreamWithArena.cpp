@@ -0,0 +1,18 @@
+#include "MultiRecordStreamWithArena.h"
+
+using namespace step;
+
+void ArenaStorage::Clear()
+{
+    // 保留已申请的容量
+    m_Arena.clear();
+    m_Records.clear();
+    m_RecordBegin = 0;
+    ClearFieldIndex();
+}
+
+void ArenaStorage::Reserve(size_t count, size_t avgBytes)
+{
+    m_Arena.reserve(count * avgBytes);
+    m_Records.reserve(count);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+ * @brief 用于多记录数据，所有记录连续存放在一块arena中
+ * 字段直接格式化进arena，没有临时缓存的二次拷贝，序列化时顺序读取
+ */
+
+#include "BasicMultiRecordStream.h"
+
+#include <utility>
+#include <vector>
+
+namespace step
+{
+    /**
+     * @brief 存储策略：连续arena + 记录的<偏移, 长度>索引
+     * arena扩容时数据整体搬移，因此索引只保存偏移
+     */
+    class ArenaStorage : public TextRecordLookup<ArenaStorage>
+    {
+    public:
+        void Clear();
+        void Reserve(size_t count, size_t avgBytes);
+
+        template <class Format>
+        void AddField(int stepid, const char *value, size_t len)
+        {
+            Format::AppendField(m_Arena, stepid, value, len);
+        }
+
+        template <class Format>
+        void EndRecord()
+        {
+            m_Records.emplace_back(m_RecordBegin, m_Arena.size() - m_RecordBegin);
+            m_RecordBegin = m_Arena.size();
+        }
+
+        void PushRecord(const char *data, size_t len)
+        {
+            m_Arena.append(data, len);
+            m_Records.emplace_back(m_RecordBegin, len);
+            m_RecordBegin = m_Arena.size();
+        }
+
+        std::pair<const char *, size_t> Record(size_t i) const
+        {
+            return std::make_pair(m_Arena.data() + m_Records[i].first, m_Records[i].second);
+        }
+
+        template <class Format>
+        void Serialize(std::string &out) const
+        {
+            for (const auto &item : m_Records)
+            {
+                out.append(m_Arena.data() + item.first, item.second);
+                Format::EndRecord(out);
+            }
+        }
+
+        size_t Count() const { return m_Records.size(); }
+        size_t DataSize() const { return m_RecordBegin; }
+
+    private:
+        std::string m_Arena;
+
+        // <偏移, 长度>
+        std::vector<std::pair<size_t, size_t>> m_Records;
+
+        // 当前记录在arena中的起始偏移
+        size_t m_RecordBegin = 0;
+    };
+
+    using MultiRecordStreamWithArena = BasicMultiRecordStream<ArenaStorage>;
+}
@@ -5,37 +5,43 @@
  * 一般使用在需要复用内存的情况
  */
 
-#include "StreamBase.h"
+#include "BasicMultiRecordStream.h"
 #include "MemBlockList.h"
-#include <map>
 
 namespace step
 {
-    class MultiRecordStreamWithMem : public StreamBase
+    /**
+     * @brief 存储策略：MemBlockList，按块复用内存
+     */
+    class MemBlockStorage : public RecordBufferStorage<MemBlockStorage>,
+                            public TextRecordLookup<MemBlockStorage>
     {
     public:
-        MultiRecordStreamWithMem() = default;
-        ~MultiRecordStreamWithMem() = default;
+        void Clear();
+        void Reserve(size_t count, size_t avgBytes);
 
-        virtual void Init() override;
-        // 反序列化
-        virtual bool DoDeserialize(const std::string &src) override;
-        // 序列化
-        virtual std::string ToSerialized() override;
+        void PushRecord(const char *data, size_t len)
+        {
+            m_MemBlockList.PushData(data, len);
+        }
 
-        void AppendRecord();
-        // 结束当条记录的添加
-        void EndAppendRecord();
+        template <class Fn>
+        void ForEach(Fn &&fn) const
+        {
+            m_MemBlockList.Traverse(std::forward<Fn>(fn));
+        }
 
-        // 添加记录
-        void AddFieldValue(int stepid, const std::string &value, bool isEscape = false);
+        std::pair<const char *, size_t> Record(size_t i) const
+        {
+            return m_MemBlockList.Get(i);
+        }
 
-        void AddFieldValue(int stepid, int value);
-        void AddFieldValue(int stepid, double value);
+        size_t Count() const { return m_MemBlockList.Count(); }
+        size_t DataSize() const { return m_MemBlockList.DataSize(); }
 
     private:
-        std::string m_TmpBuffer;
-
         MemBlockList m_MemBlockList;
     };
+
+    using MultiRecordStreamWithMem = BasicMultiRecordStream<MemBlockStorage>;
 }
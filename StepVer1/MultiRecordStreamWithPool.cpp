@@ -2,98 +2,88 @@
 
 using namespace step;
 
-MultiRecordStreamWithPool::MultiRecordStreamWithPool()
-    : m_BufferPool(s_MaxItemSize)
+SlabPoolStorage::SlabPoolStorage()
 {
+    for (int i = 0; i < s_SlabClassCount; ++i)
+    {
+        m_SlabPools[i].reset(new boost::pool<>(s_MinSlabSize << i));
+    }
+}
+
+SlabPoolStorage::~SlabPoolStorage()
+{
+    // slab由内存池析构时统一释放，系统申请的内存需要单独释放
+    Clear();
 }
 
-MultiRecordStreamWithPool::~MultiRecordStreamWithPool()
+int SlabPoolStorage::SlabClassOf(size_t len)
 {
+    int slabClass = 0;
+    size_t slabSize = s_MinSlabSize;
+    while (slabSize < len)
+    {
+        slabSize <<= 1;
+        ++slabClass;
+    }
+    return slabClass;
 }
 
-void MultiRecordStreamWithPool::Init()
+void SlabPoolStorage::Clear()
 {
     for (auto &item : m_BodyRecords)
     {
-        if (item.first == MemTypeEnum::FromPool)
+        if (item.memType == MemTypeEnum::FromPool)
         {
-            m_BufferPool.free(item.second);
+            m_SlabPools[item.slabClass]->free(item.data);
         }
         else
         {
-            free(item.second);
+            free(item.data);
         }
     }
 
     m_BodyRecords.clear();
+    m_DataSize = 0;
+    ClearRecordBuffer();
+    ClearFieldIndex();
 }
 
-bool MultiRecordStreamWithPool::DoDeserialize(const std::string &src)
+void SlabPoolStorage::Reserve(size_t count, size_t avgBytes)
 {
-    return true;
-}
+    m_BodyRecords.reserve(count);
+    ReserveRecordBuffer(avgBytes);
 
-std::string MultiRecordStreamWithPool::ToSerialized()
-{
-    std::string result;
-
-    result = BaseRecord();
-
-    for (auto &item : m_BodyRecords)
+    // 对应档位的内存池下次扩充时一次性申请count个块
+    if (count > 0 && avgBytes <= s_MaxItemSize)
     {
-        result.append(item.second);
-
-        result.push_back('\n');
+        m_SlabPools[SlabClassOf(avgBytes)]->set_next_size(count);
     }
-
-    return result;
-}
-
-void MultiRecordStreamWithPool::AppendRecord()
-{
 }
 
-void MultiRecordStreamWithPool::EndAppendRecord()
+void SlabPoolStorage::PushRecord(const char *data, size_t len)
 {
     char *cachePtr = nullptr;
     MemTypeEnum memType = MemTypeEnum::FromPool;
+    int slabClass = -1;
 
-    size_t recLen = m_TmpBuffer.size();
-
-    if (recLen > s_MaxItemSize)
+    if (len > s_MaxItemSize)
     {
         memType = MemTypeEnum::FromSys;
-        cachePtr = (char *)malloc(recLen);
+        cachePtr = (char *)malloc(len);
     }
     else
     {
-        cachePtr = (char *)m_BufferPool.malloc();
+        slabClass = SlabClassOf(len);
+        cachePtr = (char *)m_SlabPools[slabClass]->malloc();
     }
 
-    ::memcpy(cachePtr, m_TmpBuffer.c_str(), m_TmpBuffer.size());
-    m_TmpBuffer.clear();
-
-    m_BodyRecords.emplace_back(std::make_pair(memType, cachePtr));
-}
-
-void MultiRecordStreamWithPool::AddFieldValue(int stepid, const std::string &value, bool isEscape)
-{
-    if (isEscape)
+    if (cachePtr == nullptr)
     {
-        m_TmpBuffer.append(fmt::format("{}={}&", stepid, EscapeItem(value)));
+        throw std::bad_alloc();
     }
-    else
-    {
-        m_TmpBuffer.append(fmt::format("{}={}&", stepid, value));
-    }
-}
 
-void MultiRecordStreamWithPool::AddFieldValue(int stepid, int value)
-{
-    m_TmpBuffer += fmt::format("{}={}&", stepid, value);
-}
+    ::memcpy(cachePtr, data, len);
 
-void MultiRecordStreamWithPool::AddFieldValue(int stepid, double value)
-{
-    m_TmpBuffer += fmt::format("{}={}&", stepid, value);
-}
\ No newline at end of file
+    m_BodyRecords.push_back(BodyRecord{memType, slabClass, cachePtr, len});
+    m_DataSize += len;
+}
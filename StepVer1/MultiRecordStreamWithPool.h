@@ -5,45 +5,80 @@
  * 一般使用在需要复用内存的情况
  */
 
-#include "StreamBase.h"
+#include "BasicMultiRecordStream.h"
 #include <boost/pool/pool.hpp>
-#include <map>
+#include <memory>
+#include <vector>
 
 namespace step
 {
     constexpr int s_MaxItemSize = 8 * 1024;
-    class MultiRecordStreamWithPool : public StreamBase
+    // 按记录长度分档的slab：64/128/256/.../8K，每档一个内存池，各自维护空闲链
+    constexpr int s_MinSlabSize = 64;
+    constexpr int s_SlabClassCount = 8;
+
+    /**
+     * @brief 存储策略：按长度分档的boost内存池，超过 s_MaxItemSize 的记录向系统申请
+     */
+    class SlabPoolStorage : public RecordBufferStorage<SlabPoolStorage>,
+                            public TextRecordLookup<SlabPoolStorage>
     {
     public:
-        MultiRecordStreamWithPool();
-        ~MultiRecordStreamWithPool();
+        SlabPoolStorage();
+        ~SlabPoolStorage();
 
-        virtual void Init() override;
-        // 反序列化
-        virtual bool DoDeserialize(const std::string &src) override;
-        // 序列化
-        virtual std::string ToSerialized() override;
+        SlabPoolStorage(const SlabPoolStorage &) = delete;
+        SlabPoolStorage &operator=(const SlabPoolStorage &) = delete;
 
-        void AppendRecord();
-        // 结束当条记录的添加
-        void EndAppendRecord();
+        void Clear();
+        void Reserve(size_t count, size_t avgBytes);
 
-        // 添加记录
-        void AddFieldValue(int stepid, const std::string &value, bool isEscape = false);
+        void PushRecord(const char *data, size_t len);
 
-        void AddFieldValue(int stepid, int value);
-        void AddFieldValue(int stepid, double value);
+        template <class Fn>
+        void ForEach(Fn &&fn) const
+        {
+            for (const auto &item : m_BodyRecords)
+            {
+                fn(item.data, item.length);
+            }
+        }
 
-    private:
-        boost::pool<> m_BufferPool;
+        std::pair<const char *, size_t> Record(size_t i) const
+        {
+            return std::make_pair(m_BodyRecords[i].data, m_BodyRecords[i].length);
+        }
 
-        std::string m_TmpBuffer;
+        size_t Count() const { return m_BodyRecords.size(); }
+        size_t DataSize() const { return m_DataSize; }
+
+        // 第i条记录所在的slab档位，向系统申请的返回-1
+        int SlabClass(size_t i) const { return m_BodyRecords[i].slabClass; }
+
+        // 能容纳len字节的最小slab档位
+        static int SlabClassOf(size_t len);
+
+    private:
+        std::unique_ptr<boost::pool<>> m_SlabPools[s_SlabClassCount];
 
         enum class MemTypeEnum
         {
             FromPool,
             FromSys,
         };
-        std::vector<std::pair<MemTypeEnum, char *>> m_BodyRecords;
+
+        // 记录保存精确长度，序列化时不依赖结尾的'\0'
+        struct BodyRecord
+        {
+            MemTypeEnum memType;
+            int slabClass;
+            char *data;
+            size_t length;
+        };
+        std::vector<BodyRecord> m_BodyRecords;
+
+        size_t m_DataSize = 0;
     };
+
+    using MultiRecordStreamWithPool = BasicMultiRecordStream<SlabPoolStorage>;
 }
@@ -1,35 +1,54 @@
 #include "SingleRecordStream.h"
+#include "FieldIndex.h"
+
+#include <cstring>
 
 using namespace step;
 
 void SingleRecordStream::Init()
 {
     m_Items.clear();
+    m_IsInline = false;
+    m_IsInlineBaseLoaded = false;
+    m_BaseFieldCount = 0;
+    m_FieldCount = 0;
 }
 
 std::string SingleRecordStream::ToSerialized()
 {
+    LoadInlineItems();
+
     std::string result = BaseRecord();
 
     for (auto &item : m_Items)
     {
-        result.append(fmt::format("{}={}\n", item.first, item.second));
-
-        result.push_back('\n');
+        result.append(fmt::format("{}={}&", item.first, EscapeItem(item.second)));
     }
+    result.push_back('\n');
 
     return result;
 }
 
 bool SingleRecordStream::DoDeserialize(const std::string &src)
 {
+    if (src.empty())
+    {
+        return false;
+    }
+
+    Init();
+    if (DeserializeInline(src))
+    {
+        return true;
+    }
+    Init();
+
     auto records = str::Split(src, '\n');
     if (records.empty())
     {
         return false;
     }
 
-    Init();
     ParseBaseRecord(records.front());
 
     if (records.size() == 1)
@@ -57,6 +76,106 @@ bool SingleRecordStream::DoDeserialize(const std::string &src)
     return true;
 }
 
+bool SingleRecordStream::DeserializeInline(const std::string &src)
+{
+    if (src.size() > sizeof(m_InlineBuffer))
+    {
+        return false;
+    }
+    ::memcpy(m_InlineBuffer, src.data(), src.size());
+
+    bool overflow = false;
+    auto addField = [this, &overflow](int stepid, const char *value, size_t len)
+    {
+        if (m_FieldCount >= STEP_SINGLE_RECORD_INLINE_FIELDS)
+        {
+            overflow = true;
+            return;
+        }
+        m_InlineFields[m_FieldCount++] = InlineField{stepid, static_cast<uint16_t>(value - m_InlineBuffer),
+                                                     static_cast<uint16_t>(len)};
+    };
+
+    const char *end = m_InlineBuffer + src.size();
+    const char *baseEnd = static_cast<const char *>(::memchr(m_InlineBuffer, '\n', src.size()));
+    if (baseEnd == nullptr)
+    {
+        baseEnd = end;
+    }
+    ForEachField(m_InlineBuffer, baseEnd - m_InlineBuffer, addField);
+    m_BaseFieldCount = m_FieldCount;
+
+    // 只有一条包体记录，其余行忽略
+    if (baseEnd < end)
+    {
+        const char *body = baseEnd + 1;
+        const char *bodyEnd = static_cast<const char *>(::memchr(body, '\n', end - body));
+        ForEachField(body, (bodyEnd == nullptr ? end : bodyEnd) - body, addField);
+    }
+
+    m_IsInline = !overflow;
+    return m_IsInline;
+}
+
+std::pair<const char *, size_t> SingleRecordStream::FindInline(size_t begin, size_t end, int stepid) const
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (m_InlineFields[i].stepid == stepid)
+        {
+            return std::make_pair(m_InlineBuffer + m_InlineFields[i].offset, m_InlineFields[i].length);
+        }
+    }
+    return std::make_pair(nullptr, 0);
+}
+
+std::string SingleRecordStream::InlineValue(const std::pair<const char *, size_t> &raw) const
+{
+    std::string value(raw.first, raw.second);
+    if (::memchr(raw.first, '\\', raw.second) != nullptr)
+    {
+        return EscapeBackItem(value);
+    }
+    return value;
+}
+
+void SingleRecordStream::LoadBaseRecords()
+{
+    if (!m_IsInline || m_IsInlineBaseLoaded)
+    {
+        return;
+    }
+
+    // 与ParseBaseRecord一致，已有的包头字段不覆盖
+    for (size_t i = 0; i < m_BaseFieldCount; ++i)
+    {
+        const auto &field = m_InlineFields[i];
+        m_BaseRecords.emplace(field.stepid, InlineValue(std::make_pair(m_InlineBuffer + field.offset, field.length)));
+    }
+    m_IsInlineBaseLoaded = true;
+}
+
+void SingleRecordStream::LoadInlineItems()
+{
+    if (!m_IsInline)
+    {
+        return;
+    }
+
+    LoadBaseRecords();
+    // 解包得到的字段先于之后添加的字段，emplace不覆盖
+    for (size_t i = m_BaseFieldCount; i < m_FieldCount; ++i)
+    {
+        const auto &field = m_InlineFields[i];
+        m_Items.emplace(field.stepid, InlineValue(std::make_pair(m_InlineBuffer + field.offset, field.length)));
+    }
+
+    m_IsInline = false;
+    m_IsInlineBaseLoaded = false;
+    m_BaseFieldCount = 0;
+    m_FieldCount = 0;
+}
+
 const std::string &SingleRecordStream::GetFieldValue(int stepid)
 {
     auto it = m_Items.find(stepid);
@@ -65,5 +184,15 @@ const std::string &SingleRecordStream::GetFieldValue(int stepid)
         return it->second;
     }
 
+    if (m_IsInline)
+    {
+        // 读到的字段才转存到 m_Items，返回的引用在下次解包前一直有效
+        auto raw = FindInline(m_BaseFieldCount, m_FieldCount, stepid);
+        if (raw.first != nullptr)
+        {
+            return m_Items.emplace(stepid, InlineValue(raw)).first->second;
+        }
+    }
+
     return s_EmptyItem;
 }
\ No newline at end of file
@@ -3,10 +3,23 @@
 /**
  * @brief 单记录的数据
  * 一般用于声明请求包，如果确定当前应答是单记录，也可使用
+ * 不超过 STEP_SINGLE_RECORD_INLINE_SIZE 的包直接拷贝到对象内部，字段索引也内联存放，
+ * 解包不申请堆内存，读取字段时才反转义并转存到 map；超出时退回到 map 存储
  */
 
 #include "StreamBase.h"
 
+#include <cstdint>
+#include <utility>
+
+#ifndef STEP_SINGLE_RECORD_INLINE_SIZE
+#define STEP_SINGLE_RECORD_INLINE_SIZE 1024
+#endif
+
+#ifndef STEP_SINGLE_RECORD_INLINE_FIELDS
+#define STEP_SINGLE_RECORD_INLINE_FIELDS 64
+#endif
+
 namespace step
 {
     class SingleRecordStream : public StreamBase
@@ -24,12 +37,14 @@ namespace step
         template <char>
         void AddFiledValue(int stepid, char value)
         {
+            LoadInlineItems();
             m_Items.emplace(stepid, value == '\0' ? "" : std::string(1, value));
         }
 
         template <typename T>
         void AddFieldValue(int stepid, T &&value)
         {
+            LoadInlineItems();
             if constexpr (std::is_arithmetic<T>::value) // 数字类型
             {
                 m_Items.emplace(stepid, std::to_string(value));
@@ -42,8 +57,45 @@ namespace step
 
         const std::string &GetFieldValue(int stepid);
 
+        // 当前包是否存放在内联缓存中
+        bool IsInline() const { return m_IsInline; }
+
+    protected:
+        virtual void LoadBaseRecords() override;
+
+    private:
+        // 将包拷贝到内联缓存并建立字段索引，包过大或字段过多时返回false
+        bool DeserializeInline(const std::string &src);
+
+        // 在内联索引[begin, end)中查找字段，返回转义状态的原始数据
+        std::pair<const char *, size_t> FindInline(size_t begin, size_t end, int stepid) const;
+
+        std::string InlineValue(const std::pair<const char *, size_t> &raw) const;
+
+        // 将内联存储的字段全部转存到 m_BaseRecords 和 m_Items，序列化和添加字段前调用
+        void LoadInlineItems();
+
     private:
         // 存储的是已经转义回来的数据值
         std::map<int, std::string> m_Items;
+
+        struct InlineField
+        {
+            int stepid;
+            uint16_t offset;
+            uint16_t length;
+        };
+        static_assert(STEP_SINGLE_RECORD_INLINE_SIZE <= UINT16_MAX, "inline offsets are 16-bit");
+
+        bool m_IsInline = false;
+        // 内联的包头字段已转存到 m_BaseRecords
+        bool m_IsInlineBaseLoaded = false;
+
+        // 包头字段为 m_InlineFields[0, m_BaseFieldCount)，包体字段紧随其后
+        size_t m_BaseFieldCount = 0;
+        size_t m_FieldCount = 0;
+        InlineField m_InlineFields[STEP_SINGLE_RECORD_INLINE_FIELDS];
+
+        char m_InlineBuffer[STEP_SINGLE_RECORD_INLINE_SIZE];
     };
 }
\ No newline at end of file
@@ -71,8 +71,16 @@ std::string StreamBase::EscapeBackItem(const std::string &src)
     return result;
 }
 
+void StreamBase::ExpectRecords(size_t count, size_t avgBytes)
+{
+    // 序列化时每条记录后跟一个换行
+    m_ExpectedSize = count * (avgBytes + 1);
+}
+
 const std::string &StreamBase::GetBaseFieldValue(int stepid)
 {
+    LoadBaseRecords();
+
     auto it = m_BaseRecords.find(stepid);
     if (it != m_BaseRecords.end())
         return it->second;
@@ -82,7 +90,8 @@ const std::string &StreamBase::GetBaseFieldValue(int stepid)
 
 void StreamBase::SetBaseFieldValueString(int stepid, const std::string &value)
 {
-    m_BaseRecords[stepid] = EscapeItem(value);
+    // 与ParseBaseRecord一致存储原始值，序列化时再转义
+    m_BaseRecords[stepid] = value;
 }
 
 void StreamBase::ParseBaseRecord(const std::string &baseStr)
@@ -115,7 +124,7 @@ std::string StreamBase::BaseRecord() const
     {
         result.append(std::to_string(item.first));
         result.push_back('=');
-        result.append(item.second.empty() ? "" : item.second);
+        result.append(item.second.empty() ? "" : EscapeItem(item.second));
         result.push_back('&');
     }
     result.push_back('\n');
@@ -23,6 +23,13 @@ namespace step
         // 序列化
         virtual std::string ToSerialized() = 0;
 
+        /**
+         * @brief 已知记录数时给出容量提示，子类据此一次性预留存储
+         * @param count 预期记录数
+         * @param avgBytes 单条记录的平均字节数
+         */
+        virtual void ExpectRecords(size_t count, size_t avgBytes);
+
         const std::string &GetBaseFieldValue(int stepid);
         void SetBaseFieldValueString(int stepid, const std::string &value);
 
@@ -37,9 +44,15 @@ namespace step
 
         std::string BaseRecord() const;
 
+        // 子类延迟解析包头时，在读取包头字段前将其补充到 m_BaseRecords
+        virtual void LoadBaseRecords() {}
+
     protected:
         std::map<int, std::string> m_BaseRecords;
 
         static const std::string s_EmptyItem;
+
+        // 预期的包体序列化长度，序列化时据此预留输出缓存，0表示未知
+        size_t m_ExpectedSize = 0;
     };
 }
\ No newline at end of file
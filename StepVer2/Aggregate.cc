@@ -0,0 +1,188 @@
+#include "Aggregate.h"
+#include "StepVer2.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace stepver2
+{
+    namespace
+    {
+        const size_t kLanes = 4;
+
+        template <class T>
+        struct Lanes
+        {
+            T sum[kLanes];
+            T min[kLanes];
+            T max[kLanes];
+            size_t count = 0;
+
+            Lanes()
+            {
+                for (size_t j = 0; j < kLanes; ++j)
+                {
+                    sum[j] = 0;
+                    min[j] = std::numeric_limits<T>::max();
+                    max[j] = std::numeric_limits<T>::lowest();
+                }
+            }
+
+            void Add(size_t lane, T value)
+            {
+                sum[lane] += value;
+                min[lane] = std::min(min[lane], value);
+                max[lane] = std::max(max[lane], value);
+            }
+
+            Summary Result() const
+            {
+                Summary summary;
+                summary.count = count;
+                if (count == 0)
+                {
+                    return summary;
+                }
+
+                T total = 0;
+                T low = min[0];
+                T high = max[0];
+                for (size_t j = 0; j < kLanes; ++j)
+                {
+                    total += sum[j];
+                    low = std::min(low, min[j]);
+                    high = std::max(high, max[j]);
+                }
+                summary.sum = static_cast<double>(total);
+                summary.min = static_cast<double>(low);
+                summary.max = static_cast<double>(high);
+                return summary;
+            }
+        };
+
+        template <class T>
+        Summary SummarizeValues(const T *values, const uint64_t *valid, size_t size)
+        {
+            Lanes<T> lanes;
+            for (size_t begin = 0; begin < size; begin += 64)
+            {
+                size_t end = std::min(size, begin + 64);
+                uint64_t bits = valid[begin >> 6];
+                if (end - begin == 64 && bits == ~uint64_t(0))
+                {
+                    // 整组都有值，各路之间没有依赖
+                    for (size_t i = begin; i < end; i += kLanes)
+                    {
+                        for (size_t j = 0; j < kLanes; ++j)
+                        {
+                            lanes.Add(j, values[i + j]);
+                        }
+                    }
+                    lanes.count += 64;
+                    continue;
+                }
+
+                for (; bits != 0; bits &= bits - 1)
+                {
+                    size_t i = begin + __builtin_ctzll(bits);
+                    if (i >= end)
+                    {
+                        break;
+                    }
+                    lanes.Add(i & (kLanes - 1), values[i]);
+                    ++lanes.count;
+                }
+            }
+            return lanes.Result();
+        }
+
+        template <class T>
+        std::vector<Summary> SummarizeGroups(const Column &key, const T *values, const Column &value)
+        {
+            std::vector<Lanes<T>> groups(key.DictionarySize());
+            size_t rows = std::min(key.Size(), value.Size());
+            const uint32_t *codes = key.Codes();
+            for (size_t row = 0; row < rows; ++row)
+            {
+                if (key.IsNull(row) || value.IsNull(row))
+                {
+                    continue;
+                }
+                Lanes<T> &group = groups[codes[row]];
+                group.Add(0, values[row]);
+                ++group.count;
+            }
+
+            std::vector<Summary> result;
+            result.reserve(groups.size());
+            for (const auto &group : groups)
+            {
+                result.push_back(group.Result());
+            }
+            return result;
+        }
+    }
+
+    Summary Summarize(const Column &column)
+    {
+        switch (column.Type())
+        {
+        case ColumnType::Int64:
+            return SummarizeValues(column.Int64Data(), column.ValidBitmap(), column.Size());
+        case ColumnType::Double:
+            return SummarizeValues(column.DoubleData(), column.ValidBitmap(), column.Size());
+        case ColumnType::String:
+            break;
+        }
+
+        // 字符串列只统计个数
+        Summary summary;
+        summary.count = column.Size() - column.NullCount();
+        return summary;
+    }
+
+    std::vector<Summary> SummarizeBy(const Column &key, const Column &value)
+    {
+        switch (value.Type())
+        {
+        case ColumnType::Int64:
+            return SummarizeGroups(key, value.Int64Data(), value);
+        case ColumnType::Double:
+            return SummarizeGroups(key, value.DoubleData(), value);
+        case ColumnType::String:
+            break;
+        }
+
+        std::vector<Summary> result(key.DictionarySize());
+        size_t rows = std::min(key.Size(), value.Size());
+        for (size_t row = 0; row < rows; ++row)
+        {
+            if (!key.IsNull(row) && !value.IsNull(row))
+            {
+                ++result[key.Codes()[row]].count;
+            }
+        }
+        return result;
+    }
+
+    Summary Summarize(const CachedGatePBStep &step, int stepid)
+    {
+        ColumnSet columns = step.ToColumns({{stepid, ColumnType::Double}});
+        return Summarize(columns[0]);
+    }
+
+    std::vector<std::pair<std::string, Summary>> SummarizeBy(const CachedGatePBStep &step, int keyStepid,
+                                                            int valueStepid)
+    {
+        ColumnSet columns = step.ToColumns({{keyStepid, ColumnType::String}, {valueStepid, ColumnType::Double}});
+        std::vector<Summary> groups = SummarizeBy(columns[0], columns[1]);
+
+        std::vector<std::pair<std::string, Summary>> result;
+        result.reserve(groups.size());
+        for (uint32_t code = 0; code < groups.size(); ++code)
+        {
+            result.emplace_back(columns[0].Dictionary(code), groups[code]);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * @Description: 数值字段的汇总(个数、合计、最小、最大)和按小基数字段分组汇总
+ * @Author: yubo
+ * @Date: 2025-02-27
+ */
+#pragma once
+
+#include "ColumnSet.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stepver2
+{
+    // 汇总结果，空值不参与；count为0时sum、min、max都为0
+    struct Summary
+    {
+        size_t count = 0;
+        double sum = 0;
+        double min = 0;
+        double max = 0;
+
+        double Mean() const { return count == 0 ? 0 : sum / count; }
+    };
+
+    /**
+     * @brief 汇总一个数值列
+     * 按64行一组读取空值位图，整组都有值时用4路独立的累加器展开，编译器可向量化；
+     * Int64列按整数累加，结果转为double
+     */
+    Summary Summarize(const Column &column);
+
+    /**
+     * @brief 按字符串列分组汇总数值列
+     * @return 第i个元素为字典编码为i的分组，key为空的行不参与
+     */
+    std::vector<Summary> SummarizeBy(const Column &key, const Column &value);
+
+    // 直接汇总包中的字段，数值只解析一次
+    Summary Summarize(const CachedGatePBStep &step, int stepid);
+
+    /**
+     * @brief 按keyStepid的值分组汇总valueStepid，如按市场代码汇总市值
+     * @return <分组值(已反转义), 汇总结果>，按分组值首次出现的顺序
+     */
+    std::vector<std::pair<std::string, Summary>> SummarizeBy(const CachedGatePBStep &step, int keyStepid,
+                                                            int valueStepid);
+}
@@ -0,0 +1,84 @@
+#include "CapacityLearner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace stepver2
+{
+    constexpr size_t CapacityLearner::SAMPLE_COUNT;
+    constexpr size_t CapacityLearner::MAX_FUNCID_COUNT;
+
+    namespace
+    {
+        // 在前count个样本中取分位数，会打乱数组顺序
+        size_t PercentileOf(size_t *values, size_t count, double percentile)
+        {
+            size_t rank = static_cast<size_t>(std::ceil(percentile * count));
+            size_t index = std::min(count - 1, rank == 0 ? 0 : rank - 1);
+            std::nth_element(values, values + index, values + count);
+            return values[index];
+        }
+    }
+
+    CapacityLearner::CapacityLearner(double percentile, size_t maxFuncIds)
+        : percentile_(std::max(0.01, std::min(1.0, percentile))), maxFuncIds_(maxFuncIds)
+    {
+    }
+
+    void CapacityLearner::Observe(int funcid, size_t records, size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = samples_.find(funcid);
+        if (it == samples_.end())
+        {
+            if (samples_.size() >= maxFuncIds_)
+            {
+                return;
+            }
+            it = samples_.emplace(funcid, Samples()).first;
+        }
+        Samples &samples = it->second;
+        samples.records[samples.next] = records;
+        samples.bytes[samples.next] = bytes;
+        samples.next = (samples.next + 1) % SAMPLE_COUNT;
+        samples.count = std::min(samples.count + 1, SAMPLE_COUNT);
+    }
+
+    CapacityLearner::Estimate CapacityLearner::Predict(int funcid) const
+    {
+        size_t records[SAMPLE_COUNT];
+        size_t bytes[SAMPLE_COUNT];
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            auto it = samples_.find(funcid);
+            if (it == samples_.end() || it->second.count == 0)
+            {
+                return Estimate();
+            }
+
+            count = it->second.count;
+            std::copy(it->second.records, it->second.records + count, records);
+            std::copy(it->second.bytes, it->second.bytes + count, bytes);
+        }
+
+        Estimate estimate;
+        estimate.records = PercentileOf(records, count, percentile_);
+        estimate.bytes = PercentileOf(bytes, count, percentile_);
+        return estimate;
+    }
+
+    void CapacityLearner::Clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples_.clear();
+    }
+
+    CapacityLearner &CapacityLearner::Default()
+    {
+        static CapacityLearner s_Learner;
+        return s_Learner;
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * @Description: 按功能号学习应答规模，开始组包时据此预分配容量
+ * @Author: yubo
+ * @Date: 2025-02-12
+ */
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+namespace stepver2
+{
+    /**
+     * @brief 按功能号统计应答的记录数和序列化长度
+     * 每个功能号只保留最近 SAMPLE_COUNT 次样本，按分位数给出预估，
+     * 使大查询一次分配到位，小查询保持精简；
+     * 功能号来自请求，跟踪的个数有上限，已满时新的功能号不再学习，按没有样本处理
+     * 注：内部加锁，可被多个线程的对象共享
+     */
+    class CapacityLearner
+    {
+    public:
+        // 预估的应答规模
+        struct Estimate
+        {
+            size_t records = 0; // 记录数
+            size_t bytes = 0;   // 包体序列化后的长度
+        };
+
+        /**
+         * @brief 构造函数
+         * @param percentile 预估使用的分位数(0-1]，默认取P90
+         * @param maxFuncIds 最多跟踪的功能号个数
+         */
+        explicit CapacityLearner(double percentile = 0.9, size_t maxFuncIds = MAX_FUNCID_COUNT);
+
+        CapacityLearner(const CapacityLearner &) = delete;
+        CapacityLearner &operator=(const CapacityLearner &) = delete;
+
+        /**
+         * @brief 记录一次应答的实际规模
+         */
+        void Observe(int funcid, size_t records, size_t bytes);
+
+        /**
+         * @brief 预估功能号的应答规模，没有样本时返回全0
+         */
+        Estimate Predict(int funcid) const;
+
+        /**
+         * @brief 清空所有样本
+         */
+        void Clear();
+
+        /**
+         * @brief 进程内共享的默认实例
+         */
+        static CapacityLearner &Default();
+
+        static constexpr size_t SAMPLE_COUNT = 32;
+        // 默认最多跟踪的功能号个数，每个约0.5K
+        static constexpr size_t MAX_FUNCID_COUNT = 4096;
+
+    private:
+        // 环形缓冲保存最近的样本
+        struct Samples
+        {
+            size_t records[SAMPLE_COUNT];
+            size_t bytes[SAMPLE_COUNT];
+            size_t count = 0;
+            size_t next = 0;
+        };
+
+        double percentile_;
+        size_t maxFuncIds_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<int, Samples> samples_;
+    };
+}
@@ -0,0 +1,255 @@
+#include "ColumnSet.h"
+#include "DecimalParser.h"
+#include "PackageView.h"
+#include "StepVer2.h"
+#include "ValueIndex.h"
+
+#include <algorithm>
+
+namespace stepver2
+{
+    void Column::Reserve(size_t rows)
+    {
+        valid_.reserve((rows + 63) / 64);
+        switch (type_)
+        {
+        case ColumnType::Int64:
+            ints_.reserve(rows);
+            break;
+        case ColumnType::Double:
+            doubles_.reserve(rows);
+            break;
+        case ColumnType::String:
+            codes_.reserve(rows);
+            break;
+        }
+    }
+
+    size_t Column::AppendValid(bool valid)
+    {
+        size_t row = size_++;
+        if ((row & 63) == 0)
+        {
+            valid_.push_back(0);
+        }
+        if (valid)
+        {
+            valid_.back() |= uint64_t(1) << (row & 63);
+        }
+        else
+        {
+            ++nullCount_;
+        }
+        return row;
+    }
+
+    uint32_t Column::Intern(const std::string &value)
+    {
+        // 由包生成的列没有查找表，第一次追加时补上
+        for (uint32_t code = static_cast<uint32_t>(lookup_.size()); code < dictionary_.size(); ++code)
+        {
+            lookup_.emplace(dictionary_[code], code);
+        }
+
+        auto it = lookup_.find(value);
+        if (it != lookup_.end())
+        {
+            return it->second;
+        }
+
+        uint32_t code = static_cast<uint32_t>(dictionary_.size());
+        dictionary_.push_back(value);
+        lookup_.emplace(value, code);
+        return code;
+    }
+
+    void Column::AppendInt64(int64_t value)
+    {
+        AppendValid(true);
+        ints_.push_back(value);
+    }
+
+    void Column::AppendDouble(double value)
+    {
+        AppendValid(true);
+        doubles_.push_back(value);
+    }
+
+    void Column::AppendString(const std::string &value)
+    {
+        AppendValid(true);
+        codes_.push_back(Intern(value));
+    }
+
+    void Column::AppendNull()
+    {
+        AppendValid(false);
+        switch (type_)
+        {
+        case ColumnType::Int64:
+            ints_.push_back(0);
+            break;
+        case ColumnType::Double:
+            doubles_.push_back(0);
+            break;
+        case ColumnType::String:
+            codes_.push_back(0);
+            break;
+        }
+    }
+
+    size_t ColumnSet::RowsCount() const
+    {
+        size_t rows = 0;
+        for (const auto &column : columns_)
+        {
+            rows = std::max(rows, column.Size());
+        }
+        return rows;
+    }
+
+    const Column *ColumnSet::Find(int stepid) const
+    {
+        for (const auto &column : columns_)
+        {
+            if (column.StepId() == stepid)
+            {
+                return &column;
+            }
+        }
+        return nullptr;
+    }
+
+    Column &ColumnSet::AddColumn(int stepid, ColumnType type)
+    {
+        columns_.emplace_back(stepid, type);
+        return columns_.back();
+    }
+
+    void ColumnSet::FromInterned(Column &column, const InternedField &field)
+    {
+        // 字典只增不减，排序、截取后旧编码的顺序和存活与当前记录不符，按首次出现重新编号并丢弃未用的值
+        std::vector<uint32_t> remap(field.DictionarySize(), InternedField::kNull);
+        const uint32_t *codes = field.Codes();
+        for (size_t row = 0; row < field.RecordsCount(); ++row)
+        {
+            uint32_t code = codes[row];
+            bool valid = code != InternedField::kNull;
+            if (valid && remap[code] == InternedField::kNull)
+            {
+                remap[code] = static_cast<uint32_t>(column.dictionary_.size());
+                Span raw = field.Value(code);
+                column.dictionary_.push_back(CachedGatePBStep::NeedEscapeBack(raw)
+                                                 ? CachedGatePBStep::EscapeBackItem(raw.ToString())
+                                                 : raw.ToString());
+            }
+            column.AppendValid(valid);
+            column.codes_.push_back(valid ? remap[code] : 0);
+        }
+    }
+
+    void ColumnSet::Build(const CachedGatePBStep &step, const std::vector<ColumnSpec> &specs)
+    {
+        columns_.clear();
+        const size_t rows = step.bodyRecords_.size();
+        const size_t n = specs.size();
+
+        // 已建立字典的字符串列直接使用包内字典的编码，其余的列需要扫描记录
+        std::vector<size_t> scanned;
+        std::vector<int> ids;
+        for (size_t c = 0; c < n; ++c)
+        {
+            columns_.emplace_back(specs[c].stepid, specs[c].type);
+            columns_.back().Reserve(rows);
+            const InternedField *field = step.Interned().Find(specs[c].stepid);
+            if (specs[c].type == ColumnType::String && field != nullptr)
+            {
+                FromInterned(columns_.back(), *field);
+                continue;
+            }
+            scanned.push_back(c);
+            ids.push_back(specs[c].stepid);
+        }
+
+        // 字符串列先收集原始值，最后统一编码
+        std::vector<std::vector<Span>> raws(n);
+        for (size_t c : scanned)
+        {
+            if (specs[c].type == ColumnType::String)
+            {
+                raws[c].resize(rows);
+            }
+        }
+
+        // 每条记录只扫描一次，取出所有列的值
+        std::vector<Span> values(ids.size());
+        for (size_t row = 0; row < rows && !ids.empty(); ++row)
+        {
+            RecordRef(&step, row).GetFields(ids.data(), ids.size(), values.data());
+            for (size_t k = 0; k < scanned.size(); ++k)
+            {
+                size_t c = scanned[k];
+                Column &column = columns_[c];
+                Span value = values[k];
+                switch (column.type_)
+                {
+                case ColumnType::Int64:
+                {
+                    int64_t number = 0;
+                    bool valid = value.data != nullptr && ParseInt64(value, number);
+                    column.AppendValid(valid);
+                    column.ints_.push_back(valid ? number : 0);
+                    break;
+                }
+                case ColumnType::Double:
+                {
+                    double number = 0;
+                    bool valid = value.data != nullptr && ParseDecimal(value, number);
+                    column.AppendValid(valid);
+                    column.doubles_.push_back(valid ? number : 0);
+                    break;
+                }
+                case ColumnType::String:
+                    column.AppendValid(value.data != nullptr);
+                    raws[c][row] = value;
+                    break;
+                }
+            }
+        }
+
+        for (size_t c : scanned)
+        {
+            if (specs[c].type != ColumnType::String)
+            {
+                continue;
+            }
+
+            // 值相同的记录在索引中指向第一次出现的记录，第一次出现时分配编码
+            Column &column = columns_[c];
+            ValueIndex index;
+            index.Build(raws[c], ValueIndex::Mode::Unique);
+            column.codes_.resize(rows, 0);
+            for (size_t row = 0; row < rows; ++row)
+            {
+                Span raw = raws[c][row];
+                if (raw.data == nullptr)
+                {
+                    continue;
+                }
+
+                size_t first = static_cast<size_t>(index.FindRaw(raw));
+                if (first == row)
+                {
+                    column.codes_[row] = static_cast<uint32_t>(column.dictionary_.size());
+                    column.dictionary_.push_back(CachedGatePBStep::NeedEscapeBack(raw)
+                                                     ? CachedGatePBStep::EscapeBackItem(raw.ToString())
+                                                     : raw.ToString());
+                }
+                else
+                {
+                    column.codes_[row] = column.codes_[first];
+                }
+            }
+        }
+    }
+}
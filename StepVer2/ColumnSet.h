@@ -0,0 +1,123 @@
+/*
+ * @Description: 按列存放的字段值，数值列为连续数组，字符串列为字典编码
+ * @Author: yubo
+ * @Date: 2025-02-27
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace stepver2
+{
+    class CachedGatePBStep;
+    class InternedField;
+
+    enum class ColumnType
+    {
+        Int64,  // 整数，非整数的值为空
+        Double, // 十进制数，非数字的值为空
+        String  // 字典编码的字符串(已反转义)
+    };
+
+    struct ColumnSpec
+    {
+        int stepid;
+        ColumnType type;
+    };
+
+    /**
+     * @brief 一列字段值
+     * 空值(记录中没有该字段或数值无效)由位图标记，对应位置的数值为0、编码为0；
+     * 字符串列只存编码，相同的值共用一个字典项，编码按首次出现的顺序分配；
+     * 字段已建立包内字典(CachedGatePBStep::InternFields)时直接沿用其编码
+     */
+    class Column
+    {
+    public:
+        Column() = default;
+        Column(int stepid, ColumnType type) : stepid_(stepid), type_(type) {}
+
+        int StepId() const { return stepid_; }
+        ColumnType Type() const { return type_; }
+        size_t Size() const { return size_; }
+
+        bool IsNull(size_t row) const { return row >= size_ || ((valid_[row >> 6] >> (row & 63)) & 1) == 0; }
+        size_t NullCount() const { return nullCount_; }
+        // 有值的行对应位为1，每64行一个字
+        const uint64_t *ValidBitmap() const { return valid_.data(); }
+
+        const int64_t *Int64Data() const { return ints_.data(); }
+        const double *DoubleData() const { return doubles_.data(); }
+        const uint32_t *Codes() const { return codes_.data(); }
+
+        size_t DictionarySize() const { return dictionary_.size(); }
+        const std::string &Dictionary(uint32_t code) const { return dictionary_[code]; }
+
+        // 按列类型追加一行，用于组装后通过 CachedGatePBStep::AppendColumns 生成记录
+        void AppendInt64(int64_t value);
+        void AppendDouble(double value);
+        void AppendString(const std::string &value);
+        void AppendNull();
+
+        void Reserve(size_t rows);
+
+    private:
+        friend class ColumnSet;
+
+        // 追加一行的有效位，返回行号
+        size_t AppendValid(bool valid);
+        // 字典中value的编码，没有时添加
+        uint32_t Intern(const std::string &value);
+
+    private:
+        int stepid_ = 0;
+        ColumnType type_ = ColumnType::Int64;
+        size_t size_ = 0;
+        size_t nullCount_ = 0;
+
+        std::vector<uint64_t> valid_;
+        std::vector<int64_t> ints_;
+        std::vector<double> doubles_;
+        std::vector<uint32_t> codes_;
+
+        std::vector<std::string> dictionary_;
+        // 逐行追加字符串时查找字典，由包生成的列不使用
+        std::unordered_map<std::string, uint32_t> lookup_;
+    };
+
+    /**
+     * @brief 多个字段的列，由 CachedGatePBStep::ToColumns 生成，或手工组装后交给 CachedGatePBStep::AppendColumns
+     * 列中的数据都是拷贝，不引用来源包
+     */
+    class ColumnSet
+    {
+    public:
+        ColumnSet() = default;
+
+        // 行数为最长的列的行数
+        size_t RowsCount() const;
+        size_t ColumnsCount() const { return columns_.size(); }
+
+        const Column &operator[](size_t i) const { return columns_[i]; }
+        // stepid对应的列，没有时返回nullptr
+        const Column *Find(int stepid) const;
+
+        // 添加一个空列，返回的引用在ColumnSet销毁前一直有效
+        Column &AddColumn(int stepid, ColumnType type);
+
+    private:
+        friend class CachedGatePBStep;
+        void Build(const CachedGatePBStep &step, const std::vector<ColumnSpec> &specs);
+        // 由包内字典生成字符串列，不扫描记录
+        static void FromInterned(Column &column, const InternedField &field);
+
+    private:
+        // 添加列时不移动已有的列
+        std::deque<Column> columns_;
+    };
+}
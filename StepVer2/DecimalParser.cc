@@ -0,0 +1,166 @@
+#include "DecimalParser.h"
+
+#include <cstring>
+#include <limits>
+
+namespace stepver2
+{
+    namespace
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // 8个字节是否都是'0'-'9'
+        bool IsEightDigits(uint64_t chunk)
+        {
+            return (((chunk + 0x4646464646464646ULL) | (chunk - 0x3030303030303030ULL)) & 0x8080808080808080ULL) == 0;
+        }
+
+        // 把8个数字字符合并为整数，三次乘法代替8次乘加
+        uint32_t ParseEightDigits(uint64_t chunk)
+        {
+            const uint64_t mask = 0x000000FF000000FFULL;
+            const uint64_t mul1 = 100 + (1000000ULL << 32);
+            const uint64_t mul2 = 1 + (10000ULL << 32);
+            chunk -= 0x3030303030303030ULL;
+            chunk = (chunk * 10) + (chunk >> 8);
+            chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+            return static_cast<uint32_t>(chunk);
+        }
+#endif
+
+        int CountDigits(uint32_t value)
+        {
+            int digits = 0;
+            for (; value != 0; value /= 10)
+            {
+                ++digits;
+            }
+            return digits;
+        }
+
+        /**
+         * @brief 把连续的数字累加到mantissa，有效数字超过19位的部分不再累加
+         * @param digits 已累加的有效数字个数(不含前导0)
+         * @param kept 本次累加的数字个数
+         * @param dropped 本次因超过19位而舍弃的数字个数
+         */
+        const char *ParseDigits(const char *pos, const char *end, uint64_t &mantissa, int &digits, int &kept,
+                                int &dropped)
+        {
+            kept = 0;
+            dropped = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            while (end - pos >= 8 && digits + 8 <= 19)
+            {
+                uint64_t chunk = 0;
+                ::memcpy(&chunk, pos, sizeof(chunk));
+                if (!IsEightDigits(chunk))
+                {
+                    break;
+                }
+
+                uint32_t value = ParseEightDigits(chunk);
+                digits += (mantissa == 0) ? CountDigits(value) : 8;
+                mantissa = mantissa * 100000000ULL + value;
+                kept += 8;
+                pos += 8;
+            }
+#endif
+            for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*pos - '0');
+                    digits += (mantissa != 0);
+                    ++kept;
+                }
+                else
+                {
+                    ++dropped;
+                }
+            }
+            return pos;
+        }
+    }
+
+    bool ParseDecimal(Span value, double &result)
+    {
+        const char *pos = value.data;
+        const char *end = value.data + value.size;
+        if (pos == end)
+        {
+            return false;
+        }
+
+        bool negative = (*pos == '-');
+        if (negative || *pos == '+')
+        {
+            ++pos;
+        }
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int kept = 0;
+        int dropped = 0;
+        pos = ParseDigits(pos, end, mantissa, digits, kept, dropped);
+        bool anyDigit = (kept + dropped) > 0;
+        int exponent = dropped;
+
+        if (pos < end && *pos == '.')
+        {
+            pos = ParseDigits(pos + 1, end, mantissa, digits, kept, dropped);
+            anyDigit = anyDigit || (kept + dropped) > 0;
+            exponent -= kept;
+        }
+
+        if (!anyDigit || pos != end)
+        {
+            return false;
+        }
+
+        static const double s_Pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                         1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        double number = static_cast<double>(mantissa);
+        for (; exponent > 22; exponent -= 22)
+        {
+            number *= 1e22;
+        }
+        for (; exponent < -22; exponent += 22)
+        {
+            number /= 1e22;
+        }
+        number = (exponent >= 0) ? number * s_Pow10[exponent] : number / s_Pow10[-exponent];
+
+        result = negative ? -number : number;
+        return true;
+    }
+
+    bool ParseInt64(Span value, int64_t &result)
+    {
+        const char *pos = value.data;
+        const char *end = value.data + value.size;
+        if (pos == end)
+        {
+            return false;
+        }
+
+        bool negative = (*pos == '-');
+        if (negative || *pos == '+')
+        {
+            ++pos;
+        }
+
+        uint64_t magnitude = 0;
+        int digits = 0;
+        int kept = 0;
+        int dropped = 0;
+        pos = ParseDigits(pos, end, magnitude, digits, kept, dropped);
+        const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0);
+        if (kept == 0 || dropped > 0 || pos != end || magnitude > limit)
+        {
+            return false;
+        }
+
+        result = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+        return true;
+    }
+}
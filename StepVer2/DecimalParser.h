@@ -0,0 +1,25 @@
+/*
+ * @Description: 十进制数解析，按长度解析不依赖结尾符，连续8位数字一次处理
+ * @Author: yubo
+ * @Date: 2025-02-27
+ */
+#pragma once
+
+#include "RecordScanner.h"
+
+#include <cstdint>
+
+namespace stepver2
+{
+    /**
+     * @brief 解析十进制数，可带符号和小数部分
+     * 整段都是合法数字才成功，前19位有效数字按整数累加
+     */
+    bool ParseDecimal(Span value, double &result);
+
+    /**
+     * @brief 解析十进制整数，可带符号
+     * 整段都是数字且不超出int64_t范围才成功
+     */
+    bool ParseInt64(Span value, int64_t &result);
+}
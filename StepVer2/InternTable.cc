@@ -0,0 +1,114 @@
+#include "InternTable.h"
+#include "StepVer2.h"
+
+namespace stepver2
+{
+    const uint32_t InternedField::kNull;
+
+    void InternedField::Build(int stepid, const std::vector<Span> &values)
+    {
+        stepid_ = stepid;
+        dictionary_.clear();
+        slots_.assign(16, 0);
+        codes_.resize(values.size());
+        for (size_t row = 0; row < values.size(); ++row)
+        {
+            codes_[row] = (values[row].data == nullptr) ? kNull : Intern(values[row]);
+        }
+    }
+
+    uint32_t InternedField::CodeOfRaw(Span raw) const
+    {
+        if (slots_.empty() || raw.data == nullptr)
+        {
+            return kNull;
+        }
+
+        const size_t mask = slots_.size() - 1;
+        for (size_t pos = HashBytes(raw.data, raw.size) & mask; slots_[pos] != 0; pos = (pos + 1) & mask)
+        {
+            const Span &value = dictionary_[slots_[pos] - 1];
+            if (value.size == raw.size && (raw.size == 0 || ::memcmp(value.data, raw.data, raw.size) == 0))
+            {
+                return slots_[pos] - 1;
+            }
+        }
+        return kNull;
+    }
+
+    uint32_t InternedField::CodeOf(const std::string &value) const
+    {
+        if (CachedGatePBStep::NeedEscape(value))
+        {
+            std::string escaped = CachedGatePBStep::EscapeItem(value);
+            return CodeOfRaw(Span(escaped.data(), escaped.size()));
+        }
+        return CodeOfRaw(Span(value.data(), value.size()));
+    }
+
+    uint32_t InternedField::Intern(Span raw)
+    {
+        uint32_t code = CodeOfRaw(raw);
+        if (code != kNull)
+        {
+            return code;
+        }
+
+        code = static_cast<uint32_t>(dictionary_.size());
+        dictionary_.push_back(raw);
+        if (dictionary_.size() * 2 > slots_.size())
+        {
+            Grow();
+            return code;
+        }
+
+        const size_t mask = slots_.size() - 1;
+        size_t pos = HashBytes(raw.data, raw.size) & mask;
+        while (slots_[pos] != 0)
+        {
+            pos = (pos + 1) & mask;
+        }
+        slots_[pos] = code + 1;
+        return code;
+    }
+
+    void InternedField::Grow()
+    {
+        slots_.assign(slots_.size() * 2, 0);
+        const size_t mask = slots_.size() - 1;
+        for (uint32_t code = 0; code < dictionary_.size(); ++code)
+        {
+            const Span &value = dictionary_[code];
+            size_t pos = HashBytes(value.data, value.size) & mask;
+            while (slots_[pos] != 0)
+            {
+                pos = (pos + 1) & mask;
+            }
+            slots_[pos] = code + 1;
+        }
+    }
+
+    const InternedField *InternTable::Find(int stepid) const
+    {
+        for (const auto &field : fields_)
+        {
+            if (field.StepId() == stepid)
+            {
+                return &field;
+            }
+        }
+        return nullptr;
+    }
+
+    InternedField *InternTable::FindMutable(int stepid)
+    {
+        for (auto &field : fields_)
+        {
+            if (field.StepId() == stepid)
+            {
+                return &field;
+            }
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * @Description: 重复字段值的包内字典，每条记录的字段值对应一个整数编码
+ * @Author: yubo
+ * @Date: 2025-02-28
+ */
+#pragma once
+
+#include "RecordScanner.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stepver2
+{
+    /**
+     * @brief 一个字段的字典和各记录的编码
+     * 字典项引用记录中转义状态的原始值，不拷贝；编码按首次出现的顺序分配，
+     * 同一包中值相同则编码相同，比较两个值只需比较编码
+     */
+    class InternedField
+    {
+    public:
+        // 记录中没有该字段
+        static const uint32_t kNull = UINT32_MAX;
+
+        int StepId() const { return stepid_; }
+
+        // 第i个元素为第i条记录的编码
+        const uint32_t *Codes() const { return codes_.data(); }
+        size_t RecordsCount() const { return codes_.size(); }
+
+        size_t DictionarySize() const { return dictionary_.size(); }
+        // 编码对应的值，转义状态
+        Span Value(uint32_t code) const { return dictionary_[code]; }
+
+        // 值对应的编码，字典中没有时返回kNull
+        uint32_t CodeOfRaw(Span raw) const;
+        uint32_t CodeOf(const std::string &value) const;
+
+    private:
+        friend class InternTable;
+        friend class CachedGatePBStep;
+
+        void Build(int stepid, const std::vector<Span> &values);
+        // 值对应的编码，没有时加入字典
+        uint32_t Intern(Span raw);
+        // 槽位数不足时扩大一倍，负载因子不超过0.5
+        void Grow();
+
+    private:
+        int stepid_ = 0;
+        std::vector<uint32_t> codes_;
+        std::vector<Span> dictionary_;
+        // 开放寻址，存放编码+1，0为空槽位
+        std::vector<uint32_t> slots_;
+    };
+
+    /**
+     * @brief 包内各字段的字典，通过 CachedGatePBStep::InternFields 建立
+     * 记录本身不改变，序列化、视图、切分等照常引用记录数据；RecordFilter 和 ToColumns 遇到已建立字典的字段时
+     * 直接使用编码。SetFieldValue、SortBy、TopK 会同步更新编码，Merge、Compact 后按原字段重建，
+     * Init、SetPackage、AppendRecord 后清空
+     */
+    class InternTable
+    {
+    public:
+        bool Empty() const { return fields_.empty(); }
+        // stepid的字典，没有建立时返回nullptr
+        const InternedField *Find(int stepid) const;
+
+    private:
+        friend class CachedGatePBStep;
+
+        InternedField *FindMutable(int stepid);
+        void Clear() { fields_.clear(); }
+
+    private:
+        std::vector<InternedField> fields_;
+    };
+}
@@ -0,0 +1,247 @@
+#include "LzCodec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace stepver2
+{
+    namespace
+    {
+        const int kHashBits = 14;
+        const size_t kMinMatch = 4;
+        const size_t kMaxOffset = 65535;
+        // 最后5个字节总是字面量，最后一个匹配的起点距结尾至少12字节，解压时可以按8字节整块拷贝
+        const size_t kLastLiterals = 5;
+        const size_t kMatchLimit = 12;
+
+        uint32_t Read32(const uint8_t *p)
+        {
+            uint32_t value;
+            ::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint64_t Read64(const uint8_t *p)
+        {
+            uint64_t value;
+            ::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t Hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761U) >> (32 - kHashBits);
+        }
+
+        // 长度的剩余部分：每个255一个字节，最后一个字节小于255
+        uint8_t *WriteLength(uint8_t *op, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+            {
+                *op++ = 255;
+            }
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+
+        bool ReadLength(const uint8_t *&ip, const uint8_t *end, size_t &length)
+        {
+            uint8_t byte;
+            do
+            {
+                if (ip >= end)
+                {
+                    return false;
+                }
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        // 一个序列：token(高4位字面量长度，低4位匹配长度-4) + 字面量 + 2字节偏移
+        uint8_t *WriteSequence(uint8_t *op, const uint8_t *literals, size_t literalLen, size_t offset, size_t matchLen)
+        {
+            uint8_t *token = op++;
+            *token = static_cast<uint8_t>((literalLen < 15 ? literalLen : 15) << 4);
+            if (literalLen >= 15)
+            {
+                op = WriteLength(op, literalLen - 15);
+            }
+            ::memcpy(op, literals, literalLen);
+            op += literalLen;
+
+            if (matchLen == 0)
+            {
+                return op; // 最后的字面量，没有偏移
+            }
+
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            matchLen -= kMinMatch;
+            *token |= static_cast<uint8_t>(matchLen < 15 ? matchLen : 15);
+            if (matchLen >= 15)
+            {
+                op = WriteLength(op, matchLen - 15);
+            }
+            return op;
+        }
+
+        // 从ip和ref开始的相同字节数，不超过limit
+        size_t MatchLength(const uint8_t *ip, const uint8_t *ref, const uint8_t *limit)
+        {
+            const uint8_t *start = ip;
+            while (ip + 8 <= limit)
+            {
+                uint64_t diff = Read64(ip) ^ Read64(ref);
+                if (diff != 0)
+                {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                    return (ip - start) + (__builtin_ctzll(diff) >> 3);
+#else
+                    break;
+#endif
+                }
+                ip += 8;
+                ref += 8;
+            }
+            while (ip < limit && *ip == *ref)
+            {
+                ++ip;
+                ++ref;
+            }
+            return ip - start;
+        }
+    }
+
+    void LzCompress(const char *src, size_t size, std::string &out)
+    {
+        out.resize(LzBound(size));
+        const uint8_t *base = reinterpret_cast<const uint8_t *>(src);
+        const uint8_t *end = base + size;
+        const uint8_t *anchor = base;
+        uint8_t *op = reinterpret_cast<uint8_t *>(&out[0]);
+        uint8_t *const outBegin = op;
+
+        if (size > kMatchLimit)
+        {
+            // 记录每个4字节序列最近出现的位置
+            uint32_t table[1 << kHashBits] = {0};
+            const uint8_t *matchLimit = end - kMatchLimit;
+            const uint8_t *copyLimit = end - kLastLiterals;
+
+            const uint8_t *ip = base + 1;
+            while (ip < matchLimit)
+            {
+                uint32_t sequence = Read32(ip);
+                uint32_t &slot = table[Hash(sequence)];
+                const uint8_t *ref = base + slot;
+                slot = static_cast<uint32_t>(ip - base);
+
+                if (ref >= ip || static_cast<size_t>(ip - ref) > kMaxOffset || Read32(ref) != sequence)
+                {
+                    // 距上次匹配越远步长越大，不可压缩的数据很快扫过
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+
+                // 向前扩展匹配
+                while (ip > anchor && ref > base && ip[-1] == ref[-1])
+                {
+                    --ip;
+                    --ref;
+                }
+
+                size_t matchLen = kMinMatch + MatchLength(ip + kMinMatch, ref + kMinMatch, copyLimit);
+                op = WriteSequence(op, anchor, ip - anchor, ip - ref, matchLen);
+                ip += matchLen;
+                anchor = ip;
+
+                if (ip < matchLimit)
+                {
+                    table[Hash(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+                }
+            }
+        }
+
+        op = WriteSequence(op, anchor, end - anchor, 0, 0);
+        out.resize(op - outBegin);
+    }
+
+    bool LzDecompress(const char *src, size_t size, char *dst, size_t dstSize)
+    {
+        const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+        const uint8_t *const ipEnd = ip + size;
+        uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+        uint8_t *const opBegin = op;
+        uint8_t *const opEnd = op + dstSize;
+
+        while (ip < ipEnd)
+        {
+            uint8_t token = *ip++;
+
+            size_t literalLen = token >> 4;
+            if (literalLen == 15 && !ReadLength(ip, ipEnd, literalLen))
+            {
+                return false;
+            }
+            if (literalLen > static_cast<size_t>(ipEnd - ip) || literalLen > static_cast<size_t>(opEnd - op))
+            {
+                return false;
+            }
+            ::memcpy(op, ip, literalLen);
+            op += literalLen;
+            ip += literalLen;
+
+            if (ip == ipEnd)
+            {
+                break; // 最后的字面量
+            }
+
+            if (ipEnd - ip < 2)
+            {
+                return false;
+            }
+            size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - opBegin))
+            {
+                return false;
+            }
+
+            size_t matchLen = token & 15;
+            if (matchLen == 15 && !ReadLength(ip, ipEnd, matchLen))
+            {
+                return false;
+            }
+            matchLen += kMinMatch;
+            if (matchLen > static_cast<size_t>(opEnd - op))
+            {
+                return false;
+            }
+
+            const uint8_t *ref = op - offset;
+            uint8_t *matchEnd = op + matchLen;
+            if (offset >= 8 && matchLen + 8 <= static_cast<size_t>(opEnd - op))
+            {
+                // 每次拷贝8字节，源和目标相距不小于8字节，重叠部分已写好；末尾多写的字节之后会被覆盖
+                do
+                {
+                    ::memcpy(op, ref, 8);
+                    op += 8;
+                    ref += 8;
+                } while (op < matchEnd);
+                op = matchEnd;
+            }
+            else
+            {
+                while (op < matchEnd)
+                {
+                    *op++ = *ref++;
+                }
+            }
+        }
+
+        return op == opEnd;
+    }
+}
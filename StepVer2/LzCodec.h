@@ -0,0 +1,30 @@
+/*
+ * @Description: 包内记录块压缩用的LZ77编码，格式与LZ4块格式相同，不依赖外部库
+ * @Author: yubo
+ * @Date: 2025-03-01
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace stepver2
+{
+    // 压缩结果的最大长度
+    inline size_t LzBound(size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    /**
+     * @brief 压缩一段数据，结果写入out(覆盖原内容)
+     * 单遍贪心匹配，匹配窗口64KB，最短匹配4字节；连续找不到匹配时逐步加大步长跳过
+     */
+    void LzCompress(const char *src, size_t size, std::string &out);
+
+    /**
+     * @brief 解压到dst，dstSize必须等于原始长度
+     * @return 数据损坏或长度不符时返回false，不越界读写
+     */
+    bool LzDecompress(const char *src, size_t size, char *dst, size_t dstSize);
+}
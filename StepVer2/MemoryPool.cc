@@ -1,15 +1,38 @@
 #include "MemoryPool.h"
 #include <algorithm>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 namespace stepver2
 {
           // 初始化静态成员变量
     const size_t MemoryBlock::LEVEL_CAPACITIES[4] = {1024, 4096, 16384, 65536};
+    constexpr size_t MemoryBlock::HUGE_PAGE_SIZE;
 
     // MemoryBlock 实现
     MemoryBlock::MemoryBlock(int level)
-        : used_size_(0)
+        : MemoryBlock(PoolBackend::Heap, level)
+    {
+    }
+
+    MemoryBlock::MemoryBlock(PoolBackend backend, int level)
+        : mapped_(nullptr), mapped_size_(0), huge_page_state_(HugePageState::None), used_size_(0)
     {
+        if (backend == PoolBackend::HugePage)
+        {
+            // 大页块不参与分档扩充，视为最大档
+            current_level_ = 4;
+            if (!MapHugePage())
+            {
+                // 系统不支持mmap时退回堆内存，容量保持一致
+                data_.resize(HUGE_PAGE_SIZE);
+            }
+            return;
+        }
+
         // 确保level在有效范围内
         current_level_ = std::max(1, std::min(4, level));
 
@@ -18,11 +41,27 @@ namespace stepver2
         data_.resize(capacity);
     }
 
+    MemoryBlock::~MemoryBlock()
+    {
+#if defined(__linux__)
+        if (mapped_ != nullptr)
+        {
+            ::munmap(mapped_, mapped_size_);
+        }
+#endif
+    }
+
     MemoryBlock::MemoryBlock(MemoryBlock &&other) noexcept
         : data_(std::move(other.data_)),
+          mapped_(other.mapped_),
+          mapped_size_(other.mapped_size_),
+          huge_page_state_(other.huge_page_state_),
           current_level_(other.current_level_),
           used_size_(other.used_size_)
     {
+        other.mapped_ = nullptr;
+        other.mapped_size_ = 0;
+        other.huge_page_state_ = HugePageState::None;
         other.current_level_ = 1;
         other.used_size_ = 0;
     }
@@ -31,16 +70,76 @@ namespace stepver2
     {
         if (this != &other)
         {
+#if defined(__linux__)
+            if (mapped_ != nullptr)
+            {
+                ::munmap(mapped_, mapped_size_);
+            }
+#endif
             data_ = std::move(other.data_);
+            mapped_ = other.mapped_;
+            mapped_size_ = other.mapped_size_;
+            huge_page_state_ = other.huge_page_state_;
             current_level_ = other.current_level_;
             used_size_ = other.used_size_;
 
+            other.mapped_ = nullptr;
+            other.mapped_size_ = 0;
+            other.huge_page_state_ = HugePageState::None;
             other.current_level_ = 1;
             other.used_size_ = 0;
         }
         return *this;
     }
 
+    bool MemoryBlock::MapHugePage()
+    {
+#if defined(__linux__)
+#ifdef MAP_HUGETLB
+        // 优先使用hugetlbfs预留的大页，需要系统配置 vm.nr_hugepages
+        void *ptr = ::mmap(nullptr, HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            mapped_ = static_cast<char *>(ptr);
+            mapped_size_ = HUGE_PAGE_SIZE;
+            huge_page_state_ = HugePageState::HugeTLB;
+            return true;
+        }
+#endif
+        // 回退为透明大页：多映射一个大页的长度，裁剪出2MB对齐的区间
+        size_t span = HUGE_PAGE_SIZE * 2;
+        void *raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+        {
+            return false;
+        }
+
+        uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+        if (aligned > begin)
+        {
+            ::munmap(raw, aligned - begin);
+        }
+        uintptr_t tail = aligned + HUGE_PAGE_SIZE;
+        if (begin + span > tail)
+        {
+            ::munmap(reinterpret_cast<void *>(tail), begin + span - tail);
+        }
+
+        mapped_ = reinterpret_cast<char *>(aligned);
+        mapped_size_ = HUGE_PAGE_SIZE;
+#ifdef MADV_HUGEPAGE
+        ::madvise(mapped_, mapped_size_, MADV_HUGEPAGE);
+        huge_page_state_ = HugePageState::Transparent;
+#endif
+        return true;
+#else
+        return false;
+#endif
+    }
+
     size_t MemoryBlock::GetLevelCapacity(int level)
     {
         if (level < 1 || level > 4)
@@ -64,6 +163,11 @@ namespace stepver2
 
     bool MemoryBlock::ExpandToLevel(int target_level)
     {
+        if (mapped_ != nullptr)
+        {
+            return false; // 大页块容量固定
+        }
+
         if (target_level <= current_level_ || target_level > 4)
         {
             return false; // 无需扩展或目标等级无效
@@ -93,7 +197,7 @@ namespace stepver2
         size_t required_size = used_size_ + size;
 
         // 检查是否需要扩展
-        if (required_size > data_.size())
+        if (required_size > GetTotalSize())
         {
             int target_level = DetermineTargetLevel(required_size);
             if (!ExpandToLevel(target_level))
@@ -105,12 +209,12 @@ namespace stepver2
         }
 
         // 确保有足够空间
-        if (required_size > data_.size())
+        if (required_size > GetTotalSize())
         {
             return nullptr; // 即使扩展后仍然不够
         }
 
-        char *result = data_.data() + used_size_;
+        char *result = Buffer() + used_size_;
         used_size_ += size;
         return result;
     }
@@ -121,9 +225,21 @@ namespace stepver2
         // 不清零vector数据以提高性能，只重置使用量
     }
 
+    void MemoryBlock::Prefault()
+    {
+        static constexpr size_t kPageSize = 4096;
+
+        volatile char *buffer = Buffer();
+        size_t total = GetTotalSize();
+        for (size_t offset = used_size_; offset < total; offset += kPageSize)
+        {
+            buffer[offset] = 0;
+        }
+    }
+
     // MemoryPool 实现
-    MemoryPool::MemoryPool()
-        : current_block_index_(0), total_allocated_count_(0), total_allocated_size_(0)
+    MemoryPool::MemoryPool(PoolBackend backend)
+        : backend_(backend), current_block_index_(0), total_allocated_count_(0), total_allocated_size_(0)
     {
         // 预分配一个初始内存块，从第2档开始(4KB)
         AllocateNewBlock();
@@ -131,6 +247,7 @@ namespace stepver2
 
     MemoryPool::MemoryPool(MemoryPool &&other) noexcept
         : blocks_(std::move(other.blocks_)),
+          backend_(other.backend_),
           current_block_index_(other.current_block_index_),
           total_allocated_count_(other.total_allocated_count_),
           total_allocated_size_(other.total_allocated_size_)
@@ -145,6 +262,7 @@ namespace stepver2
         if (this != &other)
         {
             blocks_ = std::move(other.blocks_);
+            backend_ = other.backend_;
             current_block_index_ = other.current_block_index_;
             total_allocated_count_ = other.total_allocated_count_;
             total_allocated_size_ = other.total_allocated_size_;
@@ -205,6 +323,31 @@ namespace stepver2
         total_allocated_size_ = 0;
     }
 
+    size_t MemoryPool::Reserve(size_t bytes)
+    {
+        size_t available = 0;
+        for (const auto &block : blocks_)
+        {
+            available += block->GetAvailableSize();
+        }
+
+        while (available < bytes)
+        {
+            blocks_.push_back(std::make_unique<MemoryBlock>(backend_, 4));
+            available += blocks_.back()->GetAvailableSize();
+        }
+
+        return GetTotalSize();
+    }
+
+    void MemoryPool::Prefault()
+    {
+        for (auto &block : blocks_)
+        {
+            block->Prefault();
+        }
+    }
+
     size_t MemoryPool::GetTotalUsedSize() const
     {
         size_t total = 0;
@@ -230,7 +373,7 @@ namespace stepver2
         try
         {
             int optimal_level = DetermineOptimalInitialLevel(hint_size);
-            auto new_block = std::make_unique<MemoryBlock>(optimal_level);
+            auto new_block = std::make_unique<MemoryBlock>(backend_, optimal_level);
             blocks_.push_back(std::move(new_block));
         }
         catch (const std::exception &e)
@@ -12,6 +12,27 @@
 
 namespace stepver2
 {
+    /**
+     * @brief 内存池的底层内存来源，按内存池选择
+     * Heap: 普通堆内存，按1K/4K/16K/64K分档扩充
+     * HugePage: 以2MB大页映射的内存块，适用于10万级记录的大结果集，减少TLB miss
+     */
+    enum class PoolBackend
+    {
+        Heap,
+        HugePage,
+    };
+
+    /**
+     * @brief 大页内存块实际获得的映射方式
+     */
+    enum class HugePageState
+    {
+        None,        // 未使用大页(堆内存或映射失败后的回退)
+        HugeTLB,     // MAP_HUGETLB 映射成功
+        Transparent, // 回退为 madvise(MADV_HUGEPAGE) 透明大页
+    };
+
     /**
      * @brief 内存块类，支持4档动态扩充的内存管理
      * 第1档: 1024 bytes, 第2档: 4096 bytes, 第3档: 16384 bytes, 第4档: 65536 bytes
@@ -24,7 +45,14 @@ namespace stepver2
          * @param level 初始容量等级，如果超出范围则限制在有效范围内
          */
         explicit MemoryBlock(int level = 1);
-        ~MemoryBlock() = default;
+
+        /**
+         * @brief 构造函数，指定内存来源
+         * @param backend 为HugePage时固定分配一个2MB大页块，不再分档扩充
+         * @param level Heap时的初始等级(1-4)
+         */
+        MemoryBlock(PoolBackend backend, int level);
+        ~MemoryBlock();
 
         // 禁用拷贝构造和赋值
         MemoryBlock(const MemoryBlock &) = delete;
@@ -54,7 +82,7 @@ namespace stepver2
         /**
          * @brief 获取当前总内存大小
          */
-        size_t GetTotalSize() const { return data_.size(); }
+        size_t GetTotalSize() const { return mapped_ ? mapped_size_ : data_.size(); }
 
         /**
          * @brief 获取剩余可用内存大小
@@ -77,6 +105,19 @@ namespace stepver2
          */
         static size_t GetLevelCapacity(int level);
 
+        /**
+         * @brief 逐页写入未使用的区域，提前触发缺页
+         */
+        void Prefault();
+
+        /**
+         * @brief 获取大页映射状态，Heap内存块恒为None
+         */
+        HugePageState GetHugePageState() const { return huge_page_state_; }
+
+        // 大页内存块的容量
+        static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
     private:
         /**
          * @brief 动态扩充到指定等级
@@ -93,7 +134,19 @@ namespace stepver2
         int DetermineTargetLevel(size_t required_size) const;
 
     private:
-        std::vector<char> data_;      // 内存数据
+        /**
+         * @brief 映射2MB大页，优先MAP_HUGETLB，失败后回退为透明大页
+         * @return 映射成功返回true，失败时由调用方回退到堆内存
+         */
+        bool MapHugePage();
+
+        char *Buffer() { return mapped_ ? mapped_ : data_.data(); }
+
+    private:
+        std::vector<char> data_;      // 内存数据(Heap)
+        char *mapped_;                // 映射的大页内存(HugePage)
+        size_t mapped_size_;          // 映射的大页内存大小
+        HugePageState huge_page_state_;
         int current_level_;           // 当前容量等级
         size_t used_size_;           // 已使用的内存大小
 
@@ -109,8 +162,9 @@ namespace stepver2
     public:
         /**
          * @brief 构造函数，自动选择最优的内存块初始等级
+         * @param backend 内存来源，默认使用堆内存
          */
-        MemoryPool();
+        explicit MemoryPool(PoolBackend backend = PoolBackend::Heap);
         ~MemoryPool() = default;
 
         // 禁用拷贝构造和赋值
@@ -149,6 +203,24 @@ namespace stepver2
          */
         size_t GetBlockCount() const { return blocks_.size(); }
 
+        /**
+         * @brief 获取内存来源
+         */
+        PoolBackend GetBackend() const { return backend_; }
+
+        /**
+         * @brief 预留内存，保证空闲容量不少于指定大小
+         * 新增的内存块直接取最大档(HugePage为2MB)，避免运行期逐档扩充
+         * @param bytes 预期需要的总字节数
+         * @return 预留后的总内存大小
+         */
+        size_t Reserve(size_t bytes);
+
+        /**
+         * @brief 对所有内存块预取页面，避免首次写入时缺页
+         */
+        void Prefault();
+
     private:
         /**
          * @brief 分配新的内存块
@@ -172,6 +244,7 @@ namespace stepver2
 
     private:
         std::vector<std::unique_ptr<MemoryBlock>> blocks_; // 内存块列表
+        PoolBackend backend_;                           // 内存来源
         size_t current_block_index_;                    // 当前使用的内存块索引
         size_t total_allocated_count_;                  // 总分配次数
         size_t total_allocated_size_;                   // 总分配大小
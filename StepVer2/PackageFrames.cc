@@ -0,0 +1,132 @@
+#include "PackageFrames.h"
+#include "StepVer2.h"
+
+#include "stepdef.h"
+
+namespace stepver2
+{
+    namespace
+    {
+        const char s_NewLine[] = "\n";
+
+        size_t Digits(size_t value)
+        {
+            size_t digits = 1;
+            for (; value >= 10; value /= 10)
+            {
+                ++digits;
+            }
+            return digits;
+        }
+    }
+
+    std::string PackageFrames::ToString(size_t frame) const
+    {
+        std::string result;
+        result.reserve(Bytes(frame));
+        for (size_t i = 0; i < IovCount(frame); ++i)
+        {
+            const struct iovec &iov = Iov(frame)[i];
+            result.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+        }
+        return result;
+    }
+
+    void PackageFrames::Clear()
+    {
+        frames_.clear();
+        iov_.clear();
+        headers_.clear();
+        patched_.clear();
+    }
+
+    bool PackageFrames::Build(const CachedGatePBStep &step, size_t maxBytes)
+    {
+        Clear();
+        const auto &records = step.bodyRecords_;
+
+        // 被修改过的记录先合并补丁，之后只引用patched_中的数据
+        std::vector<size_t> patchedOffset;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (records[i].patchHead >= 0)
+            {
+                patchedOffset.resize(records.size() + 1, 0);
+                for (size_t j = i; j < records.size(); ++j)
+                {
+                    patchedOffset[j] = patched_.size();
+                    if (records[j].patchHead >= 0)
+                    {
+                        step.AppendPatchedRecord(patched_, j);
+                    }
+                }
+                patchedOffset[records.size()] = patched_.size();
+                break;
+            }
+        }
+        auto recordSpan = [&](size_t i)
+        {
+            if (records[i].patchHead >= 0)
+            {
+                return Span(patched_.data() + patchedOffset[i], patchedOffset[i + 1] - patchedOffset[i]);
+            }
+            return Span(records[i].data, records[i].data == nullptr ? 0 : records[i].length);
+        };
+
+        // 包头除记录数外的部分是固定的
+        std::string base = step.BaseRecord();
+        Span baseFields(base.data(), base.size() - 1);
+        const int returnNum = STEP_RETURNNUM;
+        const std::string empty;
+        const size_t baseFixed = ReplaceFields(baseFields, &returnNum, &empty, 1).size() + 1;
+
+        // 每帧尽量多放记录，包头长度随记录数的位数变化
+        size_t next = 0;
+        do
+        {
+            Frame frame{next, 0, 0, 0, 0};
+            size_t body = 0;
+            for (; next < records.size(); ++next)
+            {
+                size_t len = recordSpan(next).size + 1;
+                if (baseFixed + Digits(frame.records + 1) + body + len > maxBytes)
+                {
+                    break;
+                }
+                body += len;
+                ++frame.records;
+            }
+
+            if (frame.records == 0 && next < records.size())
+            {
+                Clear();
+                return false;
+            }
+
+            std::string count = std::to_string(frame.records);
+            headers_.append(ReplaceFields(baseFields, &returnNum, &count, 1)).push_back('\n');
+            frame.bytes = baseFixed + count.size() + body;
+            frames_.push_back(frame);
+        } while (next < records.size());
+
+        // headers_和patched_不再变化，可以引用其中的数据
+        size_t headerPos = 0;
+        for (auto &frame : frames_)
+        {
+            size_t headerLen = frame.bytes;
+            frame.iovBegin = iov_.size();
+            iov_.push_back(iovec{});
+            for (size_t i = frame.firstRecord; i < frame.firstRecord + frame.records; ++i)
+            {
+                Span record = recordSpan(i);
+                iov_.push_back(iovec{const_cast<char *>(record.data), record.size});
+                iov_.push_back(iovec{const_cast<char *>(s_NewLine), 1});
+                headerLen -= record.size + 1;
+            }
+            iov_[frame.iovBegin] = iovec{const_cast<char *>(headers_.data() + headerPos), headerLen};
+            headerPos += headerLen;
+            frame.iovCount = iov_.size() - frame.iovBegin;
+        }
+        return true;
+    }
+}
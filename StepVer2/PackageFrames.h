@@ -0,0 +1,64 @@
+/*
+ * @Description: 按最大帧长切分包，输出可直接writev的iovec，不拼接中间字符串
+ * @Author: yubo
+ * @Date: 2025-02-26
+ */
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace stepver2
+{
+    class CachedGatePBStep;
+
+    /**
+     * @brief CachedGatePBStep::SplitBySize 的结果
+     * 每帧是一个完整的包：包头(STEP_RETURNNUM为本帧记录数) + 连续的若干条记录。
+     * 记录直接引用来源包的数据，换行符引用静态的"\n"，只有包头和被SetFieldValue修改过的记录存放在本对象中；
+     * 来源包被修改后失效。一帧的iovec个数为 1 + 2 * 记录数，超过IOV_MAX时由调用方分批写
+     */
+    class PackageFrames
+    {
+    public:
+        PackageFrames() = default;
+
+        size_t FramesCount() const { return frames_.size(); }
+
+        const struct iovec *Iov(size_t frame) const { return iov_.data() + frames_[frame].iovBegin; }
+        size_t IovCount(size_t frame) const { return frames_[frame].iovCount; }
+        // 帧的总字节数
+        size_t Bytes(size_t frame) const { return frames_[frame].bytes; }
+        size_t RecordsCount(size_t frame) const { return frames_[frame].records; }
+
+        // 拼接成字符串，用于调试和测试
+        std::string ToString(size_t frame) const;
+
+        void Clear();
+
+    private:
+        friend class CachedGatePBStep;
+        // 切分失败(有记录单独成帧也超过maxBytes)时返回false
+        bool Build(const CachedGatePBStep &step, size_t maxBytes);
+
+    private:
+        struct Frame
+        {
+            size_t firstRecord;
+            size_t records;
+            size_t bytes;
+            size_t iovBegin;
+            size_t iovCount;
+        };
+        std::vector<Frame> frames_;
+        std::vector<struct iovec> iov_;
+
+        // 所有帧的包头，依次存放
+        std::string headers_;
+        // 合并补丁后的记录
+        std::string patched_;
+    };
+}
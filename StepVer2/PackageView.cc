@@ -0,0 +1,180 @@
+#include "PackageView.h"
+
+#include <cstdlib>
+
+#include "stepdef.h"
+
+namespace stepver2
+{
+    PackageView::PackageView(const CachedGatePBStep *step)
+        : step_(step), count_(step->bodyRecords_.size())
+    {
+    }
+
+    PackageView::PackageView(const CachedGatePBStep *step, std::shared_ptr<const std::vector<uint32_t>> rows)
+        : step_(step), count_(rows->size()), rows_(std::move(rows))
+    {
+    }
+
+    Span PackageView::Record(size_t i) const
+    {
+        if (i >= count_)
+        {
+            return Span();
+        }
+
+        const auto &record = step_->bodyRecords_[SourceIndex(i)];
+        return Span(record.data, record.data == nullptr ? 0 : record.length);
+    }
+
+    std::string PackageView::GetBaseFieldValue(int stepid) const
+    {
+        return step_ == nullptr ? std::string() : step_->GetBaseFieldValue(stepid);
+    }
+
+    std::string PackageView::BaseRecord() const
+    {
+        return step_ == nullptr ? std::string("\n") : step_->BaseRecord();
+    }
+
+    long long PackageView::TotalCount() const
+    {
+        long long total = ::atoll(GetBaseFieldValue(STEP_TOTALNUM).c_str());
+        return total > 0 ? total : static_cast<long long>(count_);
+    }
+
+    RecordRef::RecordRef(const CachedGatePBStep *step, size_t index)
+        : step_(step), index_(index)
+    {
+        const auto &record = step->bodyRecords_[index];
+        data_ = Span(record.data, record.data == nullptr ? 0 : record.length);
+    }
+
+    Span RecordRef::GetRaw(int stepid) const
+    {
+        if (step_ != nullptr && step_->bodyRecords_[index_].patchHead >= 0)
+        {
+            Span patched = step_->FindPatch(index_, stepid);
+            if (patched.data != nullptr)
+            {
+                return patched;
+            }
+        }
+        return FindField(data_, stepid);
+    }
+
+    size_t RecordRef::GetFields(const int *ids, size_t n, Span *out) const
+    {
+        size_t found = stepver2::GetFields(data_, ids, n, out);
+        if (step_ != nullptr && step_->bodyRecords_[index_].patchHead >= 0)
+        {
+            step_->ApplyPatches(index_, ids, n, out);
+            found = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                found += (out[i].data != nullptr);
+            }
+        }
+        return found;
+    }
+
+    void RecordRef::AppendTo(std::string &out) const
+    {
+        if (step_ != nullptr)
+        {
+            step_->AppendPatchedRecord(out, index_);
+        }
+    }
+
+    std::string RecordRef::GetStepValueByID(int stepid) const
+    {
+        return Unescape(GetRaw(stepid));
+    }
+
+    std::string RecordRef::Unescape(Span raw)
+    {
+        if (CachedGatePBStep::NeedEscapeBack(raw))
+        {
+            return CachedGatePBStep::EscapeBackItem(raw.ToString());
+        }
+        return raw.ToString();
+    }
+
+    RecordIterator::RecordIterator(const PackageView &view, size_t index)
+        : step_(view.step_), rows_(view.rows_), index_(index)
+    {
+    }
+
+    RecordRef RecordIterator::operator*() const
+    {
+        return RecordRef(step_, rows_ == nullptr ? index_ : (*rows_)[index_]);
+    }
+
+    RecordCursor PackageView::Cursor() const
+    {
+        return RecordCursor(*this);
+    }
+
+    RecordCursor::RecordCursor(const PackageView &view)
+        : view_(view)
+    {
+    }
+
+    void RecordCursor::Seek(size_t index)
+    {
+        if (index != index_)
+        {
+            index_ = index;
+            indexed_ = false;
+        }
+    }
+
+    void RecordCursor::BuildIndex()
+    {
+        fields_.clear();
+        Span record = Record();
+        ScanFields(record.data, record.size, [this, &record](int stepid, Span value)
+                   { fields_.push_back(Field{stepid, static_cast<uint32_t>(value.data - record.data),
+                                             static_cast<uint32_t>(value.size)}); });
+        indexed_ = true;
+    }
+
+    Span RecordCursor::GetRaw(int stepid)
+    {
+        if (!Valid())
+        {
+            return Span();
+        }
+
+        Span patched = view_.step_->FindPatch(view_.SourceIndex(index_), stepid);
+        if (patched.data != nullptr)
+        {
+            return patched;
+        }
+
+        if (!indexed_)
+        {
+            BuildIndex();
+        }
+
+        for (const auto &field : fields_)
+        {
+            if (field.stepid == stepid)
+            {
+                return Span(view_.Record(index_).data + field.offset, field.length);
+            }
+        }
+        return Span();
+    }
+
+    size_t RecordCursor::GetFields(const int *ids, size_t n, Span *out) const
+    {
+        return Valid() ? RecordRef(view_.step_, view_.SourceIndex(index_)).GetFields(ids, n, out)
+                       : stepver2::GetFields(Span(), ids, n, out);
+    }
+
+    std::string RecordCursor::GetStepValueByID(int stepid)
+    {
+        return RecordRef::Unescape(GetRaw(stepid));
+    }
+}
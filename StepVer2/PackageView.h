@@ -0,0 +1,207 @@
+/*
+ * @Description: 解包后的只读视图，多个线程可各持一个游标并发读取同一个包
+ * @Author: yubo
+ * @Date: 2025-02-21
+ */
+#pragma once
+
+#include "RecordScanner.h"
+#include "StepVer2.h"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stepver2
+{
+    class RecordCursor;
+    class PackageView;
+
+    /**
+     * @brief 对一条记录的轻量引用，只保存位置，可随意拷贝
+     * 查找字段时线性扫描，不建立索引；同一记录需要多次查找时可改用 RecordCursor
+     * 字段值已合并SetFieldValue的修改
+     */
+    class RecordRef
+    {
+    public:
+        RecordRef() = default;
+        RecordRef(const CachedGatePBStep *step, size_t index);
+
+        // 记录在来源包中的序号
+        size_t Index() const { return index_; }
+        // 记录的原始内容，格式为 id=value&id=value&，不含SetFieldValue的修改
+        Span Data() const { return data_; }
+
+        // 转义状态的原始字段值，不拷贝；未找到返回空Span(data为nullptr)
+        Span GetRaw(int stepid) const;
+        // 反转义后的字段值
+        std::string GetStepValueByID(int stepid) const;
+
+        // 一次扫描取出多个字段，见 stepver2::GetFields
+        size_t GetFields(const int *ids, size_t n, Span *out) const;
+
+        // 把合并修改后的记录追加到out(不含换行)，用于直接序列化
+        void AppendTo(std::string &out) const;
+
+        // 按顺序访问每个字段，fn(int stepid, Span value)
+        template <class Fn>
+        void ForEachField(Fn &&fn) const
+        {
+            if (step_ != nullptr)
+            {
+                step_->ForEachRecordField(index_, std::forward<Fn>(fn));
+            }
+        }
+
+    private:
+        friend class RecordCursor;
+        // 仅在含转义字符时反转义
+        static std::string Unescape(Span raw);
+
+    private:
+        const CachedGatePBStep *step_ = nullptr;
+        Span data_;
+        size_t index_ = 0;
+    };
+
+    // 按记录中的顺序访问每个字段，fn(int stepid, Span value)
+    template <class Fn>
+    void ForEachField(const RecordRef &record, Fn &&fn)
+    {
+        record.ForEachField(std::forward<Fn>(fn));
+    }
+
+    // 迭代器保存来源包和共享的记录序号表，不引用视图本身，由临时视图得到的迭代器仍然有效
+    class RecordIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RecordRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const RecordRef *;
+        using reference = RecordRef;
+
+        RecordIterator() = default;
+        RecordIterator(const PackageView &view, size_t index);
+
+        RecordRef operator*() const;
+
+        RecordIterator &operator++()
+        {
+            ++index_;
+            return *this;
+        }
+
+        RecordIterator operator++(int)
+        {
+            RecordIterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        bool operator==(const RecordIterator &other) const
+        {
+            return index_ == other.index_ && step_ == other.step_ && rows_ == other.rows_;
+        }
+        bool operator!=(const RecordIterator &other) const { return !(*this == other); }
+
+    private:
+        const CachedGatePBStep *step_ = nullptr;
+        std::shared_ptr<const std::vector<uint32_t>> rows_;
+        size_t index_ = 0;
+    };
+
+    /**
+     * @brief CachedGatePBStep 的只读视图，通过 CachedGatePBStep::View() 获取
+     * 视图本身不保存状态，读取不修改来源对象；来源对象被修改(Init、SetPackage、添加或设置字段)后视图失效
+     * 经 RecordFilter 筛选得到的视图只包含选中的记录，记录序号表共享，拷贝视图不拷贝序号表
+     */
+    class PackageView
+    {
+    public:
+        PackageView() = default;
+
+        size_t RecordsCount() const { return count_; }
+
+        // 第i条记录，格式为 id=value&id=value&
+        Span Record(size_t i) const;
+        // 第i条记录在来源包中的序号
+        size_t SourceIndex(size_t i) const { return rows_ == nullptr ? i : (*rows_)[i]; }
+
+        // 来源包的包头字段(已反转义)，筛选后的视图不会更新其中的记录数
+        std::string GetBaseFieldValue(int stepid) const;
+        // 来源包的包头记录，含换行
+        std::string BaseRecord() const;
+        // 包头的总记录数(STEP_TOTALNUM)，没有时按视图的记录数计
+        long long TotalCount() const;
+
+        // 新的游标，位于第一条记录
+        RecordCursor Cursor() const;
+
+        // 按顺序遍历记录：for (RecordRef record : step.View())
+        RecordIterator begin() const { return RecordIterator(*this, 0); }
+        RecordIterator end() const { return RecordIterator(*this, count_); }
+
+    private:
+        friend class CachedGatePBStep;
+        friend class RecordIterator;
+        friend class RecordCursor;
+        friend class RecordFilter;
+        explicit PackageView(const CachedGatePBStep *step);
+        PackageView(const CachedGatePBStep *step, std::shared_ptr<const std::vector<uint32_t>> rows);
+
+    private:
+        const CachedGatePBStep *step_ = nullptr;
+        size_t count_ = 0;
+        // 选中记录在来源包中的序号，为空时表示全部记录
+        std::shared_ptr<const std::vector<uint32_t>> rows_;
+    };
+
+    /**
+     * @brief 只读的记录游标
+     * 位置和当前记录的字段索引都属于游标自己，游标不能跨线程共享，但同一视图的多个游标可以并发使用
+     */
+    class RecordCursor
+    {
+    public:
+        explicit RecordCursor(const PackageView &view);
+
+        bool Valid() const { return index_ < view_.RecordsCount(); }
+        size_t Index() const { return index_; }
+
+        void GotoFirst() { Seek(0); }
+        void GotoNext() { Seek(index_ + 1); }
+        void Seek(size_t index);
+
+        // 当前记录的原始内容，不含SetFieldValue的修改
+        Span Record() const { return Valid() ? view_.Record(index_) : Span(); }
+
+        // 转义状态的原始字段值，不拷贝；未找到返回空Span(data为nullptr)
+        Span GetRaw(int stepid);
+        // 反转义后的字段值
+        std::string GetStepValueByID(int stepid);
+
+        // 一次扫描当前记录取出多个字段，不使用也不建立字段索引
+        size_t GetFields(const int *ids, size_t n, Span *out) const;
+
+    private:
+        // 首次查找时为当前记录建立字段索引
+        void BuildIndex();
+
+    private:
+        PackageView view_;
+        size_t index_ = 0;
+
+        struct Field
+        {
+            int stepid;
+            uint32_t offset;
+            uint32_t length;
+        };
+        std::vector<Field> fields_;
+        bool indexed_ = false;
+    };
+}
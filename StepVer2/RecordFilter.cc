@@ -0,0 +1,222 @@
+#include "RecordFilter.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "DecimalParser.h"
+
+namespace stepver2
+{
+    namespace
+    {
+        // 一般不会有这么多不同字段，超出时退回到堆上
+        const size_t kInlineFields = 16;
+    }
+
+    size_t RecordFilter::FieldSlot(int stepid)
+    {
+        auto it = std::find(ids_.begin(), ids_.end(), stepid);
+        if (it != ids_.end())
+        {
+            return it - ids_.begin();
+        }
+        ids_.push_back(stepid);
+        return ids_.size() - 1;
+    }
+
+    RecordFilter &RecordFilter::Equal(int stepid, const std::string &value)
+    {
+        Condition condition;
+        condition.op = Op::Equal;
+        condition.field = FieldSlot(stepid);
+        condition.value = CachedGatePBStep::NeedEscape(value) ? CachedGatePBStep::EscapeItem(value) : value;
+        conditions_.push_back(std::move(condition));
+        return *this;
+    }
+
+    RecordFilter &RecordFilter::Range(int stepid, double low, double high)
+    {
+        Condition condition;
+        condition.op = Op::Range;
+        condition.field = FieldSlot(stepid);
+        condition.low = low;
+        condition.high = high;
+        conditions_.push_back(std::move(condition));
+        return *this;
+    }
+
+    RecordFilter &RecordFilter::In(int stepid, const std::vector<std::string> &values)
+    {
+        Condition condition;
+        condition.op = Op::In;
+        condition.field = FieldSlot(stepid);
+        condition.setBegin = sets_.size();
+        for (const auto &value : values)
+        {
+            sets_.push_back(CachedGatePBStep::NeedEscape(value) ? CachedGatePBStep::EscapeItem(value) : value);
+        }
+        condition.setEnd = sets_.size();
+        std::sort(sets_.begin() + condition.setBegin, sets_.end());
+        conditions_.push_back(std::move(condition));
+        return *this;
+    }
+
+    bool RecordFilter::InSet(const Condition &condition, Span value) const
+    {
+        size_t low = condition.setBegin;
+        size_t high = condition.setEnd;
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            int cmp = CompareBytes(value, Span(sets_[mid].data(), sets_[mid].size()));
+            if (cmp == 0)
+            {
+                return true;
+            }
+            if (cmp < 0)
+            {
+                high = mid;
+            }
+            else
+            {
+                low = mid + 1;
+            }
+        }
+        return false;
+    }
+
+    bool RecordFilter::Evaluate(const Span *values, uint64_t skip) const
+    {
+        for (size_t i = 0; i < conditions_.size(); ++i)
+        {
+            if (i < 64 && ((skip >> i) & 1) != 0)
+            {
+                continue;
+            }
+
+            const Condition &condition = conditions_[i];
+            Span value = values[condition.field];
+            if (value.data == nullptr)
+            {
+                return false;
+            }
+
+            switch (condition.op)
+            {
+            case Op::Equal:
+                if (CompareBytes(value, Span(condition.value.data(), condition.value.size())) != 0)
+                {
+                    return false;
+                }
+                break;
+            case Op::Range:
+            {
+                double number = 0;
+                if (!ParseDecimal(value, number) || number < condition.low || number > condition.high)
+                {
+                    return false;
+                }
+                break;
+            }
+            case Op::In:
+                if (!InSet(condition, value))
+                {
+                    return false;
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool RecordFilter::Match(const RecordRef &record, uint64_t skip) const
+    {
+        Span inlineValues[kInlineFields];
+        std::vector<Span> heapValues;
+        Span *values = inlineValues;
+        if (ids_.size() > kInlineFields)
+        {
+            heapValues.resize(ids_.size());
+            values = heapValues.data();
+        }
+
+        record.GetFields(ids_.data(), ids_.size(), values);
+        return Evaluate(values, skip);
+    }
+
+    uint64_t RecordFilter::CompileCoded(const CachedGatePBStep &step, std::vector<CodedCondition> &coded) const
+    {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < conditions_.size() && i < 64; ++i)
+        {
+            const Condition &condition = conditions_[i];
+            const InternedField *field = step.Interned().Find(ids_[condition.field]);
+            if (field == nullptr || condition.op == Op::Range)
+            {
+                continue;
+            }
+
+            CodedCondition item{i, field->Codes(), InternedField::kNull, {}};
+            if (condition.op == Op::Equal)
+            {
+                item.code = field->CodeOfRaw(Span(condition.value.data(), condition.value.size()));
+            }
+            else
+            {
+                item.members.assign(field->DictionarySize(), 0);
+                for (size_t j = condition.setBegin; j < condition.setEnd; ++j)
+                {
+                    uint32_t code = field->CodeOfRaw(Span(sets_[j].data(), sets_[j].size()));
+                    if (code != InternedField::kNull)
+                    {
+                        item.members[code] = 1;
+                    }
+                }
+            }
+            coded.push_back(std::move(item));
+            mask |= uint64_t(1) << i;
+        }
+        return mask;
+    }
+
+    PackageView RecordFilter::Apply(const PackageView &view) const
+    {
+        // 选择性强的条件只命中少量记录，序号表按需增长，不按来源记录数预留
+        auto rows = std::make_shared<std::vector<uint32_t>>();
+
+        std::vector<CodedCondition> coded;
+        uint64_t skip = 0;
+        if (view.step_ != nullptr && !view.step_->Interned().Empty())
+        {
+            skip = CompileCoded(*view.step_, coded);
+        }
+        const bool scan = conditions_.size() > coded.size();
+
+        for (size_t i = 0; i < view.RecordsCount(); ++i)
+        {
+            size_t source = view.SourceIndex(i);
+            bool matched = true;
+            for (const auto &item : coded)
+            {
+                uint32_t code = item.codes[source];
+                bool hit = item.members.empty() ? (code == item.code && code != InternedField::kNull)
+                                                : (code != InternedField::kNull && item.members[code] != 0);
+                if (!hit)
+                {
+                    matched = false;
+                    break;
+                }
+            }
+
+            if (matched && scan)
+            {
+                matched = Match(RecordRef(view.step_, source), skip);
+            }
+            if (matched)
+            {
+                rows->push_back(static_cast<uint32_t>(source));
+            }
+        }
+        return PackageView(view.step_, std::move(rows));
+    }
+}
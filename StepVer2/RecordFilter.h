@@ -0,0 +1,91 @@
+/*
+ * @Description: 按条件筛选记录，结果为引用原包数据的视图
+ * @Author: yubo
+ * @Date: 2025-02-25
+ */
+#pragma once
+
+#include "PackageView.h"
+#include "RecordScanner.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stepver2
+{
+    /**
+     * @brief 记录筛选条件，多个条件之间为"并且"
+     * 条件添加时即编译好：比较值预先转义，同一stepid只取一次，筛选时对每条记录一次扫描取出所有字段
+     * 筛选结果只新建记录序号表，记录数据仍在来源包中，来源包被修改后结果失效；
+     * 来源包对Equal、In的字段建立了字典(CachedGatePBStep::InternFields)时，这些条件比较编码，条件全部如此时不扫描记录；
+     * Apply 不修改筛选条件，同一个 RecordFilter 可被多个线程同时使用
+     *
+     *   RecordFilter filter;
+     *   filter.Equal(STEP_SCDM, "SH").Range(STEP_XQJG, 0, 100);
+     *   PackageView selected = filter.Apply(step.View());
+     */
+    class RecordFilter
+    {
+    public:
+        RecordFilter() = default;
+
+        // 字段值等于value
+        RecordFilter &Equal(int stepid, const std::string &value);
+        // 字段值是数字且在[low, high]内
+        RecordFilter &Range(int stepid, double low, double high);
+        // 字段值是values之一
+        RecordFilter &In(int stepid, const std::vector<std::string> &values);
+
+        size_t ConditionsCount() const { return conditions_.size(); }
+
+        // 筛选视图中的记录，没有条件时选中全部；结果可以再次筛选
+        PackageView Apply(const PackageView &view) const;
+        PackageView Apply(const CachedGatePBStep &step) const { return Apply(step.View()); }
+
+        // 单条记录是否满足所有条件，没有的字段视为不满足
+        bool Match(const RecordRef &record) const { return Match(record, 0); }
+
+    private:
+        enum class Op
+        {
+            Equal,
+            Range,
+            In
+        };
+
+        struct Condition
+        {
+            Op op;
+            size_t field;      // 字段值在ids_中的位置
+            std::string value; // Equal的比较值(已转义)
+            double low = 0;
+            double high = 0;
+            size_t setBegin = 0; // In的取值在sets_中的范围，已排序
+            size_t setEnd = 0;
+        };
+
+        // 按字典编码比较的条件
+        struct CodedCondition
+        {
+            size_t condition;
+            const uint32_t *codes;
+            uint32_t code;                // Equal的编码
+            std::vector<uint8_t> members; // In的取值，按编码标记
+        };
+
+        // stepid在ids_中的位置，没有时添加
+        size_t FieldSlot(int stepid);
+        // 把能按编码比较的条件转换出来，返回这些条件的位标记
+        uint64_t CompileCoded(const CachedGatePBStep &step, std::vector<CodedCondition> &coded) const;
+        // skip中标记的条件已比较过，不再比较
+        bool Match(const RecordRef &record, uint64_t skip) const;
+        bool Evaluate(const Span *values, uint64_t skip) const;
+        bool InSet(const Condition &condition, Span value) const;
+
+    private:
+        std::vector<int> ids_;
+        std::vector<Condition> conditions_;
+        std::vector<std::string> sets_;
+    };
+}
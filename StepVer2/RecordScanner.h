@@ -0,0 +1,214 @@
+/*
+ * @Description: 记录 id=value& 的有界扫描，只在给定长度内查找，不依赖结尾符
+ * @Author: yubo
+ * @Date: 2025-02-21
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace stepver2
+{
+    // 不拥有数据的只读片段，数据的生命周期由来源对象保证
+    struct Span
+    {
+        const char *data = nullptr;
+        size_t size = 0;
+
+        Span() = default;
+        Span(const char *d, size_t n) : data(d), size(n) {}
+
+        bool empty() const { return size == 0; }
+        std::string ToString() const { return data == nullptr ? std::string() : std::string(data, size); }
+
+        bool operator==(const char *str) const
+        {
+            size_t len = ::strlen(str);
+            return len == size && (size == 0 || ::memcmp(data, str, size) == 0);
+        }
+        bool operator!=(const char *str) const { return !(*this == str); }
+    };
+
+    // 字段值的哈希(FNV-1a)，供按值查找的索引和字典使用
+    inline uint64_t HashBytes(const char *data, size_t len)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // 按字节的字典序比较，前缀较短的在前；返回值同memcmp，供排序、筛选和有序合并使用
+    inline int CompareBytes(Span lhs, Span rhs)
+    {
+        int cmp = ::memcmp(lhs.data, rhs.data, std::min(lhs.size, rhs.size));
+        if (cmp != 0)
+        {
+            return cmp;
+        }
+        return lhs.size < rhs.size ? -1 : (lhs.size > rhs.size ? 1 : 0);
+    }
+
+    /**
+     * @brief 从pos开始解析一个字段，并把pos移到下一个字段
+     * 与ParseBaseRecord一致，遇到不含'='的字段视为结束
+     * @return 没有更多字段时返回false
+     */
+    inline bool NextField(const char *&pos, const char *end, int &stepid, Span &value)
+    {
+        if (pos >= end)
+        {
+            return false;
+        }
+
+        const char *itemEnd = static_cast<const char *>(::memchr(pos, '&', end - pos));
+        if (itemEnd == nullptr)
+        {
+            itemEnd = end;
+        }
+
+        const char *eq = static_cast<const char *>(::memchr(pos, '=', itemEnd - pos));
+        if (eq == nullptr)
+        {
+            pos = end;
+            return false;
+        }
+
+        int id = 0;
+        bool negative = (*pos == '-');
+        for (const char *digit = negative ? pos + 1 : pos; digit < eq && *digit >= '0' && *digit <= '9'; ++digit)
+        {
+            id = id * 10 + (*digit - '0');
+        }
+
+        stepid = negative ? -id : id;
+        value = Span(eq + 1, itemEnd - eq - 1);
+        pos = itemEnd + 1;
+        return true;
+    }
+
+    /**
+     * @brief 逐个解析记录中的字段，不申请内存
+     * @param fn 回调 fn(int stepid, Span value)，value为转义状态的原始数据
+     */
+    template <class Fn>
+    void ScanFields(const char *data, size_t len, Fn &&fn)
+    {
+        const char *pos = data;
+        int stepid = 0;
+        Span value;
+        while (NextField(pos, data + len, stepid, value))
+        {
+            fn(stepid, value);
+        }
+    }
+
+    /**
+     * @brief 按记录中的顺序访问每个字段，一次扫描，不申请内存
+     * @param fn 回调 fn(int stepid, Span value)，value为转义状态的原始数据
+     */
+    template <class Fn>
+    void ForEachField(Span record, Fn &&fn)
+    {
+        ScanFields(record.data, record.size, std::forward<Fn>(fn));
+    }
+
+    /**
+     * @brief 在记录中查找字段，找到第一个即返回
+     * @return 转义状态的原始数据，未找到时data为nullptr
+     */
+    inline Span FindField(Span record, int stepid)
+    {
+        const char *pos = record.data;
+        int id = 0;
+        Span value;
+        while (NextField(pos, record.data + record.size, id, value))
+        {
+            if (id == stepid)
+            {
+                return value;
+            }
+        }
+        return Span();
+    }
+
+    /**
+     * @brief 一次扫描取出多个字段，全部找到后提前结束
+     * 重复的stepid取第一个
+     * @param out 输出，与ids一一对应，未找到的data为nullptr
+     * @return 找到的字段个数
+     */
+    inline size_t GetFields(Span record, const int *ids, size_t n, Span *out)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = Span();
+        }
+
+        size_t found = 0;
+        const char *pos = record.data;
+        int id = 0;
+        Span value;
+        while (found < n && NextField(pos, record.data + record.size, id, value))
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (ids[i] == id && out[i].data == nullptr)
+                {
+                    out[i] = value;
+                    ++found;
+                }
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief 替换记录中的字段值，没有的字段按stepid顺序插入，用于改写包头中的记录数等
+     * @param ids 按升序排列；原记录按stepid升序时结果仍然有序
+     * @param values 与ids一一对应，为转义后的值
+     * @return 新记录，不含换行
+     */
+    inline std::string ReplaceFields(Span record, const int *ids, const std::string *values, size_t n)
+    {
+        std::string result;
+        result.reserve(record.size + n * 16);
+        auto append = [&result](int stepid, const char *data, size_t size)
+        {
+            result.append(std::to_string(stepid)).push_back('=');
+            result.append(data, size).push_back('&');
+        };
+
+        size_t next = 0;
+        const char *pos = record.data;
+        int stepid = 0;
+        Span value;
+        while (NextField(pos, record.data + record.size, stepid, value))
+        {
+            for (; next < n && ids[next] < stepid; ++next)
+            {
+                append(ids[next], values[next].data(), values[next].size());
+            }
+            if (next < n && ids[next] == stepid)
+            {
+                append(stepid, values[next].data(), values[next].size());
+                ++next;
+                continue;
+            }
+            append(stepid, value.data, value.size);
+        }
+        for (; next < n; ++next)
+        {
+            append(ids[next], values[next].data(), values[next].size());
+        }
+        return result;
+    }
+}
@@ -0,0 +1,172 @@
+#include "RecordSort.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace stepver2
+{
+    namespace
+    {
+        struct NumericItem
+        {
+            uint64_t key;
+            uint32_t row;
+        };
+
+        struct LexicalItem
+        {
+            uint64_t prefix; // 前8个字节按大端拼成的整数，大部分比较只需比较它
+            Span value;
+            uint32_t row;
+        };
+
+        // 把double映射为按无符号整数比较即有序的键
+        uint64_t OrderedBits(double value)
+        {
+            value += 0.0; // -0.0 与 0.0 相同
+            uint64_t bits = 0;
+            ::memcpy(&bits, &value, sizeof(bits));
+            return (bits & 0x8000000000000000ULL) ? ~bits : (bits | 0x8000000000000000ULL);
+        }
+
+        uint64_t Prefix(Span value)
+        {
+            uint64_t prefix = 0;
+            for (size_t i = 0; i < 8; ++i)
+            {
+                prefix = (prefix << 8) | (i < value.size ? static_cast<unsigned char>(value.data[i]) : 0);
+            }
+            return prefix;
+        }
+
+        // LSD基数排序，每轮8位，所有记录该字节相同的轮次跳过；稳定
+        void RadixSort(std::vector<NumericItem> &items)
+        {
+            std::vector<NumericItem> buffer(items.size());
+            for (int shift = 0; shift < 64; shift += 8)
+            {
+                size_t counts[257] = {};
+                for (const auto &item : items)
+                {
+                    ++counts[((item.key >> shift) & 0xFF) + 1];
+                }
+                if (counts[((items.front().key >> shift) & 0xFF) + 1] == items.size())
+                {
+                    continue;
+                }
+
+                for (int i = 0; i < 256; ++i)
+                {
+                    counts[i + 1] += counts[i];
+                }
+                for (const auto &item : items)
+                {
+                    buffer[counts[(item.key >> shift) & 0xFF]++] = item;
+                }
+                items.swap(buffer);
+            }
+        }
+
+        bool LexicalLess(const LexicalItem &lhs, const LexicalItem &rhs)
+        {
+            if (lhs.prefix != rhs.prefix)
+            {
+                return lhs.prefix < rhs.prefix;
+            }
+
+            return CompareBytes(lhs.value, rhs.value) < 0;
+        }
+    }
+
+    std::vector<uint32_t> SortPermutation(const std::vector<Span> &values, SortKey key, SortOrder order,
+                                          size_t limit)
+    {
+        std::vector<uint32_t> result;
+        result.reserve(values.size());
+        // 没有该字段或数值无效的记录，按原顺序放在最后
+        std::vector<uint32_t> missing;
+
+        if (key == SortKey::Numeric)
+        {
+            std::vector<NumericItem> items;
+            items.reserve(values.size());
+            for (size_t row = 0; row < values.size(); ++row)
+            {
+                double number = 0;
+                if (values[row].data != nullptr && ParseDecimal(values[row], number))
+                {
+                    uint64_t bits = OrderedBits(number);
+                    items.push_back(NumericItem{order == SortOrder::Asc ? bits : ~bits, static_cast<uint32_t>(row)});
+                }
+                else
+                {
+                    missing.push_back(static_cast<uint32_t>(row));
+                }
+            }
+
+            if (limit < items.size() / 8)
+            {
+                // 只取前几名时部分排序更快，以序号为次序保证相等的保持原顺序
+                std::partial_sort(items.begin(), items.begin() + limit, items.end(),
+                                  [](const NumericItem &lhs, const NumericItem &rhs)
+                                  { return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.row < rhs.row; });
+                items.resize(limit);
+            }
+            else if (!items.empty())
+            {
+                RadixSort(items);
+            }
+
+            for (const auto &item : items)
+            {
+                result.push_back(item.row);
+            }
+        }
+        else
+        {
+            std::vector<LexicalItem> items;
+            items.reserve(values.size());
+            for (size_t row = 0; row < values.size(); ++row)
+            {
+                if (values[row].data != nullptr)
+                {
+                    items.push_back(LexicalItem{Prefix(values[row]), values[row], static_cast<uint32_t>(row)});
+                }
+                else
+                {
+                    missing.push_back(static_cast<uint32_t>(row));
+                }
+            }
+
+            bool desc = (order == SortOrder::Desc);
+            auto less = [desc](const LexicalItem &lhs, const LexicalItem &rhs)
+            {
+                bool before = desc ? LexicalLess(rhs, lhs) : LexicalLess(lhs, rhs);
+                bool after = desc ? LexicalLess(lhs, rhs) : LexicalLess(rhs, lhs);
+                return before || (!after && lhs.row < rhs.row);
+            };
+
+            if (limit < items.size())
+            {
+                std::partial_sort(items.begin(), items.begin() + limit, items.end(), less);
+                items.resize(limit);
+            }
+            else
+            {
+                std::sort(items.begin(), items.end(), less);
+            }
+
+            for (const auto &item : items)
+            {
+                result.push_back(item.row);
+            }
+        }
+
+        result.insert(result.end(), missing.begin(), missing.end());
+        if (result.size() > limit)
+        {
+            result.resize(limit);
+        }
+        return result;
+    }
+}
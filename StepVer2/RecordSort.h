@@ -0,0 +1,37 @@
+/*
+ * @Description: 记录排序，只计算记录的排列顺序，不搬移记录数据
+ * @Author: yubo
+ * @Date: 2025-02-25
+ */
+#pragma once
+
+#include "DecimalParser.h"
+#include "RecordScanner.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stepver2
+{
+    enum class SortKey
+    {
+        Numeric, // 按数值比较
+        Lexical  // 按字节比较
+    };
+
+    enum class SortOrder
+    {
+        Asc,
+        Desc
+    };
+
+    /**
+     * @brief 计算记录的排列顺序
+     * 排序键一次性提取到连续数组中，数值键使用基数排序
+     * @param values 第i个元素为第i条记录的排序字段值(转义状态)，data为nullptr表示没有该字段
+     * @param limit 只需要前limit个结果，其余的顺序不保证
+     * @return 排好序的记录序号；没有该字段或数值无效的记录排在最后；相等的保持原顺序
+     */
+    std::vector<uint32_t> SortPermutation(const std::vector<Span> &values, SortKey key, SortOrder order,
+                                          size_t limit);
+}
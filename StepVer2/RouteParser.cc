@@ -0,0 +1,109 @@
+#include "RouteParser.h"
+
+#include "stepdef.h"
+
+#include <climits>
+
+namespace stepver2
+{
+    namespace
+    {
+        // 解析[pos, end)整段为十进制整数，不接受空值和超过18位的数字
+        bool ParseInt(const char *pos, const char *end, int64_t &value)
+        {
+            bool negative = (pos < end && *pos == '-');
+            if (negative)
+            {
+                ++pos;
+            }
+            if (pos == end || end - pos > 18)
+            {
+                return false;
+            }
+
+            int64_t result = 0;
+            for (; pos < end; ++pos)
+            {
+                if (*pos < '0' || *pos > '9')
+                {
+                    return false;
+                }
+                result = result * 10 + (*pos - '0');
+            }
+
+            value = negative ? -result : result;
+            return true;
+        }
+    }
+
+    uint64_t ParseHeadInts(const char *data, size_t len, const int *ids, int64_t *values, size_t count)
+    {
+        const uint64_t all = (count >= 64) ? ~uint64_t(0) : ((uint64_t(1) << count) - 1);
+        uint64_t found = 0;
+        uint64_t seen = 0;
+
+        const char *pos = data;
+        const char *end = data + len;
+        while (pos < end && *pos != '\n' && seen != all)
+        {
+            // 字段 id=value&，与ParseBaseRecord一致，遇到不含'='的字段停止
+            const char *idBegin = pos;
+            while (pos < end && *pos != '=' && *pos != '&' && *pos != '\n')
+            {
+                ++pos;
+            }
+            if (pos == end || *pos != '=')
+            {
+                break;
+            }
+
+            int64_t stepid = 0;
+            bool validId = ParseInt(idBegin, pos, stepid);
+
+            const char *valBegin = ++pos;
+            while (pos < end && *pos != '&' && *pos != '\n')
+            {
+                ++pos;
+            }
+
+            for (size_t i = 0; validId && i < count && i < 64; ++i)
+            {
+                uint64_t bit = uint64_t(1) << i;
+                if (ids[i] == stepid && (seen & bit) == 0)
+                {
+                    seen |= bit;
+                    if (ParseInt(valBegin, pos, values[i]))
+                    {
+                        found |= bit;
+                    }
+                    break;
+                }
+            }
+
+            if (pos < end && *pos == '&')
+            {
+                ++pos;
+            }
+        }
+
+        return found;
+    }
+
+    bool ParseRoute(const char *data, size_t len, RouteInfo &route)
+    {
+        static const int ids[] = {STEP_FUNC, STEP_SESSION, STEP_REQUESTNO};
+        int64_t values[] = {0, 0, 0};
+
+        uint64_t found = ParseHeadInts(data, len, ids, values, 3);
+        // 功能号按int处理(与GetFuncId一致)，超出范围的视为无效，不截断
+        if (values[0] < INT_MIN || values[0] > INT_MAX)
+        {
+            found &= ~uint64_t(1);
+            values[0] = 0;
+        }
+        route.funcId = static_cast<int>(values[0]);
+        route.session = values[1];
+        route.requestNo = values[2];
+        return (found & 1) != 0;
+    }
+}
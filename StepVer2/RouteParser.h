@@ -0,0 +1,44 @@
+/*
+ * @Description: 分发线程使用的包头路由解析，只扫描第一行，不申请内存
+ * @Author: yubo
+ * @Date: 2025-02-20
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace stepver2
+{
+    // 分发线程选择worker所需的字段
+    struct RouteInfo
+    {
+        int funcId = 0;
+        int64_t session = 0;
+        int64_t requestNo = 0;
+    };
+
+    /**
+     * @brief 从包头提取指定stepid的整数值
+     * 只扫描到第一个'\n'为止。值中的转义序列(\\、\a、\b、\n)不会被误认为分隔符，
+     * 但它们不是数字，含转义或其他非数字字符的字段视为无效；重复的stepid取第一个
+     * @param ids 需要提取的stepid
+     * @param values 输出，与ids一一对应，未提取到的保持不变
+     * @param count ids的个数，最多64个
+     * @return 提取结果的掩码，第i位表示ids[i]已提取
+     */
+    uint64_t ParseHeadInts(const char *data, size_t len, const int *ids, int64_t *values, size_t count);
+
+    /**
+     * @brief 提取STEP_FUNC、STEP_SESSION、STEP_REQUESTNO
+     * 完整的SetPackage留给worker线程执行
+     * @return 包头中没有有效的STEP_FUNC时返回false，超出int范围的功能号同样无效，此时funcId为0
+     */
+    bool ParseRoute(const char *data, size_t len, RouteInfo &route);
+
+    inline bool ParseRoute(const std::string &src, RouteInfo &route)
+    {
+        return ParseRoute(src.data(), src.size(), route);
+    }
+}
@@ -0,0 +1,139 @@
+#include "SortedMerge.h"
+
+#include <algorithm>
+
+#include "stepdef.h"
+
+namespace stepver2
+{
+    SortedMerge::SortedMerge(int stepid, SortKey key, SortOrder order)
+        : stepid_(stepid), key_(key), order_(order)
+    {
+    }
+
+    void SortedMerge::Add(const PackageView &source)
+    {
+        Head head;
+        head.view = source;
+        heads_.push_back(head);
+        recordsCount_ += source.RecordsCount();
+    }
+
+    void SortedMerge::LoadKey(Head &head) const
+    {
+        RecordRef record = *RecordIterator(head.view, head.pos);
+        head.text = record.GetRaw(stepid_);
+        head.hasKey = (head.text.data != nullptr);
+        if (head.hasKey && key_ == SortKey::Numeric)
+        {
+            head.hasKey = ParseDecimal(head.text, head.number);
+        }
+    }
+
+    bool SortedMerge::Before(size_t a, size_t b) const
+    {
+        const Head &lhs = heads_[a];
+        const Head &rhs = heads_[b];
+        if (lhs.hasKey != rhs.hasKey)
+        {
+            return lhs.hasKey;
+        }
+
+        if (lhs.hasKey)
+        {
+            int cmp = 0;
+            if (key_ == SortKey::Numeric)
+            {
+                cmp = (lhs.number < rhs.number) ? -1 : (lhs.number > rhs.number ? 1 : 0);
+            }
+            else
+            {
+                cmp = CompareBytes(lhs.text, rhs.text);
+            }
+
+            if (cmp != 0)
+            {
+                return (order_ == SortOrder::Asc) ? cmp < 0 : cmp > 0;
+            }
+        }
+        return a < b;
+    }
+
+    bool SortedMerge::Next(RecordRef &record)
+    {
+        // std::*_heap是大顶堆，比较取反得到小顶堆
+        auto after = [this](size_t a, size_t b)
+        { return Before(b, a); };
+
+        if (!started_)
+        {
+            started_ = true;
+            for (size_t i = 0; i < heads_.size(); ++i)
+            {
+                if (heads_[i].view.RecordsCount() > 0)
+                {
+                    LoadKey(heads_[i]);
+                    heap_.push_back(i);
+                }
+            }
+            std::make_heap(heap_.begin(), heap_.end(), after);
+        }
+
+        if (heap_.empty())
+        {
+            return false;
+        }
+
+        std::pop_heap(heap_.begin(), heap_.end(), after);
+        size_t source = heap_.back();
+        Head &head = heads_[source];
+        record = *RecordIterator(head.view, head.pos);
+
+        if (++head.pos < head.view.RecordsCount())
+        {
+            LoadKey(head);
+            std::push_heap(heap_.begin(), heap_.end(), after);
+        }
+        else
+        {
+            heap_.pop_back();
+        }
+        ++consumed_;
+        return true;
+    }
+
+    std::string SortedMerge::ToString(size_t limit)
+    {
+        size_t count = std::min(limit, recordsCount_ - consumed_);
+        long long total = 0;
+        for (const auto &head : heads_)
+        {
+            total += head.view.TotalCount();
+        }
+
+        std::string base = heads_.empty() ? std::string("\n") : heads_.front().view.BaseRecord();
+        const int ids[] = {STEP_RETURNNUM, STEP_TOTALNUM};
+        const std::string values[] = {std::to_string(count), std::to_string(total)};
+        std::string result = ReplaceFields(Span(base.data(), base.size() - 1), ids, values, 2);
+        result.push_back('\n');
+
+        size_t sample = 0;
+        for (const auto &head : heads_)
+        {
+            if (head.view.RecordsCount() > 0)
+            {
+                sample = head.view.Record(0).size;
+                break;
+            }
+        }
+        result.reserve(result.size() + count * (sample + 1));
+
+        ForEach([&result](const RecordRef &record)
+                {
+                    record.AppendTo(result);
+                    result.push_back('\n');
+                },
+                count);
+        return result;
+    }
+}
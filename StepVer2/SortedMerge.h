@@ -0,0 +1,95 @@
+/*
+ * @Description: 多个已排序包的k路归并，边归并边输出，可只取前N条
+ * @Author: yubo
+ * @Date: 2025-02-26
+ */
+#pragma once
+
+#include "PackageView.h"
+#include "RecordSort.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stepver2
+{
+    /**
+     * @brief 按同一字段归并多个已有序的包
+     * 每个来源只保留当前记录的排序键，取一条记录的开销与来源个数有关，与总记录数无关；
+     * 没有该字段(数值比较时还包括非数字)的记录视为最大，值相等时先取前面添加的来源。
+     * 来源包在归并完成前不能修改
+     *
+     *   SortedMerge merge(STEP_XXNR, SortKey::Numeric);
+     *   merge.Add(nodeA);
+     *   merge.Add(nodeB);
+     *   std::string firstPage = merge.ToString(100);
+     */
+    class SortedMerge
+    {
+    public:
+        explicit SortedMerge(int stepid, SortKey key = SortKey::Lexical, SortOrder order = SortOrder::Asc);
+
+        // 添加一个已按排序字段有序的来源，需在取记录之前添加
+        void Add(const PackageView &source);
+        void Add(const CachedGatePBStep &source) { Add(source.View()); }
+
+        // 所有来源的记录总数
+        size_t RecordsCount() const { return recordsCount_; }
+
+        // 取下一条记录，全部取完返回false
+        bool Next(RecordRef &record);
+
+        /**
+         * @brief 依次把归并后的记录交给sink，最多limit条
+         * @param sink 回调 sink(const RecordRef &record)
+         * @return 输出的记录数
+         */
+        template <class Fn>
+        size_t ForEach(Fn &&sink, size_t limit = SIZE_MAX)
+        {
+            size_t count = 0;
+            RecordRef record;
+            while (count < limit && Next(record))
+            {
+                sink(record);
+                ++count;
+            }
+            return count;
+        }
+
+        /**
+         * @brief 把尚未取出的归并结果直接写成包，最多limit条
+         * 包头取第一个来源的包头，STEP_RETURNNUM为本次输出的记录数，STEP_TOTALNUM为各来源总记录数之和
+         */
+        std::string ToString(size_t limit = SIZE_MAX);
+
+    private:
+        struct Head
+        {
+            PackageView view;
+            size_t pos = 0;
+            bool hasKey = false; // 当前记录有有效的排序键
+            double number = 0;
+            Span text;
+        };
+
+        // 读取来源当前记录的排序键
+        void LoadKey(Head &head) const;
+        // 来源a的当前记录是否排在来源b之前
+        bool Before(size_t a, size_t b) const;
+
+    private:
+        int stepid_;
+        SortKey key_;
+        SortOrder order_;
+
+        std::vector<Head> heads_;
+        // 还有记录的来源组成的小顶堆
+        std::vector<size_t> heap_;
+        bool started_ = false;
+        size_t recordsCount_ = 0;
+        // 已经取出的记录数
+        size_t consumed_ = 0;
+    };
+}
@@ -1,6 +1,15 @@
 #include "StepVer2.h"
+#include "PackageView.h"
+#include "PackageFrames.h"
+#include "ColumnSet.h"
+#include "LzCodec.h"
 
 #include "../Tool/StringFunc.h"
+#include "stepdef.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cstring>
 
 namespace stepver2
 {
@@ -13,7 +22,8 @@ namespace stepver2
         {'\\', '\\'}, {'=', 'a'}, {'&', 'b'}, {'\n', 'n'}};
 
     
-    CachedGatePBStep::CachedGatePBStep()
+    CachedGatePBStep::CachedGatePBStep(PoolBackend backend)
+        : memoryPool_(backend)
     {
         tmpBuffer_.reserve(1024);
         bodyRecords_.reserve(128);
@@ -22,46 +32,200 @@ namespace stepver2
     void CachedGatePBStep::Init()
     {
         baseRecord_.clear();
+        inlineBase_ = false;
+        inlineBaseCount_ = 0;
         bodyRecords_.clear();
+        patches_.clear();
+        deadBytes_ = 0;
         memoryPool_.Reset();
+        sharedPools_.clear();
+        interned_.Clear();
+        chunks_.clear();
+        compressedRecords_ = 0;
+        compressedInterned_.clear();
         tmpBuffer_.clear();
 
         currentRecIndex_ = -1;
+        expectedOutputSize_ = 0;
+        learningFuncId_ = -1;
+    }
+
+    WarmUpReport CachedGatePBStep::WarmUp(const WarmUpProfile &profile)
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        Init();
+        bodyRecords_.reserve(profile.records);
+        // 临时缓存存放单条记录，留出一倍余量应对记录长度波动
+        tmpBuffer_.reserve(profile.avgRecordBytes * 2);
+
+        memoryPool_.Reserve(profile.records * profile.avgRecordBytes);
+        memoryPool_.Prefault();
+
+        WarmUpReport report;
+        report.objects = 1;
+        report.reservedBytes = memoryPool_.GetTotalSize();
+        report.elapsedUs = warmup::ElapsedUs(begin);
+        return report;
+    }
+
+    void CachedGatePBStep::BeginResponse(int funcid)
+    {
+        Init();
+        SetBaseFieldValueInt(STEP_FUNC, funcid);
+
+        if (capacityLearner_ == nullptr)
+        {
+            return;
+        }
+
+        learningFuncId_ = funcid;
+        CapacityLearner::Estimate estimate = capacityLearner_->Predict(funcid);
+        Presize(estimate.records, estimate.bytes);
+    }
+
+    void CachedGatePBStep::ExpectRecords(size_t count, size_t avgBytes)
+    {
+        // 序列化时每条记录后跟一个换行
+        Presize(count, count * (avgBytes + 1));
+    }
+
+    void CachedGatePBStep::Presize(size_t records, size_t bytes)
+    {
+        if (records == 0 || bytes == 0)
+        {
+            return;
+        }
+
+        bodyRecords_.reserve(records);
+        memoryPool_.Reserve(bytes);
+        // 临时缓存存放单条记录，留出一倍余量应对记录长度波动
+        tmpBuffer_.reserve(bytes / records * 2);
+        expectedOutputSize_ = bytes;
     }
 
     bool CachedGatePBStep::SetPackage(const std::string &src)
     {
-        auto records = str::Split(src, '\n');
-        if (records.empty())
+        if (src.empty())
         {
             return false;
         }
 
         Init();
-        ParseBaseRecord(records.front());
 
-        for (size_t i = 1; i < records.size(); ++i)
+        const char *pos = src.data();
+        const char *end = pos + src.size();
+        const char *baseEnd = static_cast<const char *>(::memchr(pos, '\n', src.size()));
+        if (baseEnd == nullptr)
         {
-            GotoNext();
-            if (records[i].empty())
+            baseEnd = end;
+        }
+
+        // 每条包体记录最多补一个'&'
+        bool useInline = src.size() < sizeof(inlinePackage_) &&
+                         src.size() + std::count(pos, end, '\n') <= sizeof(inlinePackage_);
+        size_t inlineSize = 0;
+        if (useInline)
+        {
+            inlineSize = baseEnd - pos;
+            ::memcpy(inlinePackage_, pos, inlineSize);
+        }
+        if (!useInline || !IndexInlineBase(inlineSize))
+        {
+            ParseBaseRecord(std::string(pos, baseEnd));
+        }
+
+        for (pos = baseEnd + 1; pos < end;)
+        {
+            const char *lineEnd = static_cast<const char *>(::memchr(pos, '\n', end - pos));
+            if (lineEnd == nullptr)
             {
-                continue;
+                lineEnd = end;
+            }
+
+            size_t len = lineEnd - pos;
+            if (len > 0)
+            {
+                bool padding = (pos[len - 1] != '&'); // 补位
+                char *cachePtr = nullptr;
+                if (useInline)
+                {
+                    cachePtr = inlinePackage_ + inlineSize;
+                    ::memcpy(cachePtr, pos, len);
+                    inlineSize += len + padding;
+                }
+                else
+                {
+                    // 行尾之后是'\n'或字符串结尾的'\0'，多拷贝的一个字节随后改写为'&'
+                    cachePtr = memoryPool_.Allocate(pos, len + padding);
+                }
+
+                if (padding)
+                {
+                    cachePtr[len] = '&';
+                }
+                bodyRecords_.emplace_back(RecordInfo(cachePtr, len + padding));
             }
+            pos = lineEnd + 1;
+        }
+        GotoFirst();
+        return true;
+    }
 
-            auto &currBuf = records[i];
-            if (currBuf.back() != '&')
+    bool CachedGatePBStep::IndexInlineBase(size_t baseLen)
+    {
+        // 与ParseBaseRecord一致：字段以'&'分隔，遇到不含'='的字段停止
+        const char *pos = inlinePackage_;
+        const char *end = inlinePackage_ + baseLen;
+        inlineBaseCount_ = 0;
+        while (pos < end)
+        {
+            const char *itemEnd = static_cast<const char *>(::memchr(pos, '&', end - pos));
+            if (itemEnd == nullptr)
             {
-                currBuf.push_back('&'); // 补位
+                itemEnd = end;
             }
 
-            char *cachePtr = memoryPool_.Allocate(currBuf.data(), currBuf.size());
+            const char *eq = static_cast<const char *>(::memchr(pos, '=', itemEnd - pos));
+            if (eq == nullptr)
+            {
+                break;
+            }
 
-            bodyRecords_.emplace_back(RecordInfo(cachePtr, currBuf.size()));
+            if (inlineBaseCount_ >= STEPVER2_INLINE_BASE_FIELDS)
+            {
+                inlineBaseCount_ = 0;
+                return false;
+            }
+
+            inlineBaseFields_[inlineBaseCount_++] = InlineField{
+                ::atoi(pos),
+                static_cast<uint16_t>(eq + 1 - inlinePackage_),
+                static_cast<uint16_t>(itemEnd - eq - 1)};
+            pos = itemEnd + 1;
         }
-        GotoFirst();
+
+        inlineBase_ = true;
         return true;
     }
 
+    void CachedGatePBStep::LoadInlineBase()
+    {
+        if (!inlineBase_)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < inlineBaseCount_; ++i)
+        {
+            const auto &field = inlineBaseFields_[i];
+            baseRecord_.emplace(field.stepid,
+                                EscapeBackItem(std::string(inlinePackage_ + field.offset, field.length)));
+        }
+        inlineBase_ = false;
+        inlineBaseCount_ = 0;
+    }
+
     void CachedGatePBStep::ParseBaseRecord(const std::string &baseStr)
     {
         auto items = str::Split(baseStr, '&');
@@ -87,26 +251,75 @@ namespace stepver2
 
     std::string CachedGatePBStep::ToString()
     {
-        std::string result;
-        if (!bodyRecords_.empty())
+        std::string result = BaseRecord();
+        size_t baseSize = result.size();
+
+        if (IsCompressed())
         {
-            result.reserve(bodyRecords_.size() * bodyRecords_.front().length + 1024);
+            // 按块直接解压到输出中
+            size_t rawSize = 0;
+            for (const auto &chunk : chunks_)
+            {
+                rawSize += chunk.rawSize;
+            }
+            result.reserve(baseSize + rawSize);
+            for (size_t i = 0; i < chunks_.size(); ++i)
+            {
+                AppendChunk(result, i);
+            }
+        }
+        else if (expectedOutputSize_ > 0)
+        {
+            result.reserve(baseSize + expectedOutputSize_);
+        }
+        else if (!bodyRecords_.empty())
+        {
+            result.reserve(baseSize + bodyRecords_.size() * (bodyRecords_.front().length + 1));
         }
 
-        result = BaseRecord();
-
-        for (auto &item : bodyRecords_)
+        for (size_t i = 0; i < bodyRecords_.size(); ++i)
         {
-            result.append(item.data, item.length);
+            AppendPatchedRecord(result, i);
             result.push_back('\n');
         }
 
+        if (learningFuncId_ >= 0 && capacityLearner_ != nullptr)
+        {
+            capacityLearner_->Observe(learningFuncId_, RecordsCount(), result.size() - baseSize);
+            learningFuncId_ = -1;
+        }
+
         return result;
     }
 
     std::string CachedGatePBStep::BaseRecord() const
     {
         std::string result;
+        if (inlineBase_)
+        {
+            // 与map存储的输出一致：按stepid升序，重复的stepid保留第一个；内联的值本身就是转义过的
+            InlineField fields[STEPVER2_INLINE_BASE_FIELDS];
+            std::copy(inlineBaseFields_, inlineBaseFields_ + inlineBaseCount_, fields);
+            std::stable_sort(fields, fields + inlineBaseCount_,
+                             [](const InlineField &lhs, const InlineField &rhs)
+                             { return lhs.stepid < rhs.stepid; });
+
+            for (size_t i = 0; i < inlineBaseCount_; ++i)
+            {
+                if (i > 0 && fields[i].stepid == fields[i - 1].stepid)
+                {
+                    continue;
+                }
+                fmt::format_int id(fields[i].stepid);
+                result.append(id.data(), id.size());
+                result.push_back('=');
+                result.append(inlinePackage_ + fields[i].offset, fields[i].length);
+                result.push_back('&');
+            }
+            result.push_back('\n');
+            return result;
+        }
+
         for (const auto &item : baseRecord_)
         {
             result.append(std::to_string(item.first));
@@ -126,6 +339,34 @@ namespace stepver2
         }
 
         std::string result;
+        if (IsCompressed())
+        {
+            // 只解压与[start, end)相交的块
+            std::string buffer;
+            size_t first = 0;
+            for (size_t i = 0; i < chunks_.size() && first < static_cast<size_t>(end); ++i)
+            {
+                size_t last = first + chunks_[i].records;
+                if (last > static_cast<size_t>(start))
+                {
+                    buffer.clear();
+                    AppendChunk(buffer, i);
+                    size_t pos = 0;
+                    for (size_t rec = first; rec < last && rec < static_cast<size_t>(end); ++rec)
+                    {
+                        size_t next = buffer.find('\n', pos) + 1;
+                        if (rec >= static_cast<size_t>(start))
+                        {
+                            result.append(buffer, pos, next - pos);
+                        }
+                        pos = next;
+                    }
+                }
+                first = last;
+            }
+            return result;
+        }
+
         if (start < end)
         {
             result.reserve((end - start) * bodyRecords_[start].length + 1024);
@@ -133,7 +374,7 @@ namespace stepver2
 
         for (int i = start; i < end && i < (int)bodyRecords_.size(); ++i)
         {
-            result.append(bodyRecords_[i].data, bodyRecords_[i].length);
+            AppendPatchedRecord(result, i);
             result.push_back('\n');
         }
 
@@ -149,7 +390,9 @@ namespace stepver2
             tmpBuffer_.clear();
         }
 
+        EnsureDecompressed();
         bodyRecords_.emplace_back(RecordInfo());
+        interned_.Clear();
         // 序号更新到下一条
         GotoNext();
     }
@@ -175,74 +418,227 @@ namespace stepver2
         tmpBuffer_.clear();
     }
 
-    void CachedGatePBStep::GotoFirst()
+    PackageView CachedGatePBStep::View() const
     {
-        currentRecIndex_ = 0;
+        CheckDecompressed();
+        return PackageView(this);
     }
 
-    void CachedGatePBStep::GotoNext()
+    std::vector<Span> CachedGatePBStep::FieldValues(int stepid) const
     {
-        ++currentRecIndex_;
+        std::vector<Span> values(bodyRecords_.size());
+        for (size_t i = 0; i < bodyRecords_.size(); ++i)
+        {
+            const RecordInfo &record = bodyRecords_[i];
+            if (record.data == nullptr)
+            {
+                continue;
+            }
+
+            values[i] = FindPatch(i, stepid);
+            if (values[i].data == nullptr)
+            {
+                values[i] = FindField(Span(record.data, record.length), stepid);
+            }
+        }
+        return values;
     }
 
-    std::pair<const char *, int> CachedGatePBStep::FindItem(int stepid)
+    ValueIndex CachedGatePBStep::BuildIndex(int stepid, ValueIndex::Mode mode) const
     {
-        if (currentRecIndex_ < 0 || bodyRecords_.empty())
-        { // 无包体记录
-            return {nullptr, 0};
+        CheckDecompressed();
+        ValueIndex index;
+        index.Build(FieldValues(stepid), mode);
+        return index;
+    }
+
+    bool CachedGatePBStep::SplitBySize(size_t maxBytes, PackageFrames &frames) const
+    {
+        return !IsCompressed() && frames.Build(*this, maxBytes);
+    }
+
+    ColumnSet CachedGatePBStep::ToColumns(const std::vector<ColumnSpec> &specs) const
+    {
+        CheckDecompressed();
+        ColumnSet columns;
+        columns.Build(*this, specs);
+        return columns;
+    }
+
+    void CachedGatePBStep::AppendColumns(const ColumnSet &columns)
+    {
+        // 字段名和字符串字典只格式化一次
+        std::vector<std::string> prefixes(columns.ColumnsCount());
+        std::vector<std::vector<std::string>> dictionaries(columns.ColumnsCount());
+        for (size_t c = 0; c < columns.ColumnsCount(); ++c)
+        {
+            const Column &column = columns[c];
+            prefixes[c] = fmt::format("{}=", column.StepId());
+            for (uint32_t code = 0; code < column.DictionarySize(); ++code)
+            {
+                dictionaries[c].push_back(EscapeItem(column.Dictionary(code)));
+            }
         }
 
-        const char *begin = bodyRecords_[currentRecIndex_].data;
-        int limitedLen = bodyRecords_[currentRecIndex_].length;
+        const size_t rows = columns.RowsCount();
+        bodyRecords_.reserve(bodyRecords_.size() + rows);
+        for (size_t row = 0; row < rows; ++row)
+        {
+            AppendRecord();
+            for (size_t c = 0; c < columns.ColumnsCount(); ++c)
+            {
+                const Column &column = columns[c];
+                if (column.IsNull(row))
+                {
+                    continue;
+                }
 
-        if (begin == nullptr)
-        { // 记录尚未添加记录
-            return {nullptr, 0};
+                tmpBuffer_.append(prefixes[c]);
+                switch (column.Type())
+                {
+                case ColumnType::Int64:
+                {
+                    fmt::format_int value(column.Int64Data()[row]);
+                    tmpBuffer_.append(value.data(), value.size());
+                    break;
+                }
+                case ColumnType::Double:
+                    fmt::format_to(std::back_inserter(tmpBuffer_), "{}", column.DoubleData()[row]);
+                    break;
+                case ColumnType::String:
+                    tmpBuffer_.append(dictionaries[c][column.Codes()[row]]);
+                    break;
+                }
+                tmpBuffer_.push_back('&');
+            }
+            EndAppendRecord();
         }
+    }
 
-        char key[16];
-        int keylen = sprintf(key, "%d=", stepid);
+    void CachedGatePBStep::SortBy(int stepid, SortKey key, SortOrder order)
+    {
+        Reorder(stepid, key, order, bodyRecords_.size());
+    }
 
-        if (::strncmp(begin, key, strlen(key)) == 0)
+    void CachedGatePBStep::TopK(int stepid, size_t k, SortKey key, SortOrder order)
+    {
+        Reorder(stepid, key, order, k);
+    }
+
+    void CachedGatePBStep::Reorder(int stepid, SortKey key, SortOrder order, size_t limit)
+    {
+        EnsureDecompressed();
+        // 先取出全部排序键再排序，排序过程中不再访问记录
+        std::vector<uint32_t> rows = SortPermutation(FieldValues(stepid), key, order, limit);
+
+        // 补丁挂在RecordInfo上，随记录一起移动
+        std::vector<RecordInfo> sorted;
+        sorted.reserve(rows.size());
+        for (uint32_t row : rows)
         {
-            // 匹配到头
-            const char *tValPtr = begin + strlen(key);
-            const char *tValueEnd = ::strstr(tValPtr, "&");
-            int tLen = tValueEnd - tValPtr;
-            return std::make_pair(tValPtr, tLen);
+            sorted.push_back(bodyRecords_[row]);
         }
-        else
+        bodyRecords_.swap(sorted);
+        currentRecIndex_ = bodyRecords_.empty() ? -1 : 0;
+
+        for (auto &field : interned_.fields_)
         {
-            // 非头，则修改key继续查找
-            keylen = sprintf(key, "&%d=", stepid);
+            std::vector<uint32_t> codes;
+            codes.reserve(rows.size());
+            for (uint32_t row : rows)
+            {
+                codes.push_back(field.codes_[row]);
+            }
+            field.codes_.swap(codes);
         }
+    }
 
-        const char *fPtr = ::strstr(begin, key);
-        // 确认非key的情况
-        // 1. 返回为空
-        // 2. 返回指针与头之间的距离超出限制
-        if (fPtr == nullptr)
+    void CachedGatePBStep::InternFields(const std::vector<int> &stepids)
+    {
+        EnsureDecompressed();
+        for (int stepid : stepids)
         {
-            return {nullptr, 0};
+            InternedField *field = interned_.FindMutable(stepid);
+            if (field == nullptr)
+            {
+                interned_.fields_.emplace_back();
+                field = &interned_.fields_.back();
+            }
+            field->Build(stepid, FieldValues(stepid));
+        }
+    }
+
+    void CachedGatePBStep::RebuildInterned()
+    {
+        for (auto &field : interned_.fields_)
+        {
+            field.Build(field.stepid_, FieldValues(field.stepid_));
         }
-        const char *valPtr = fPtr + keylen;
-        if (int(fPtr - begin) + keylen >= limitedLen)
+    }
+
+    void CachedGatePBStep::UpdateInterned(size_t rec, int stepid, Span value)
+    {
+        InternedField *field = interned_.FindMutable(stepid);
+        if (field != nullptr && rec < field->codes_.size())
         {
+            field->codes_[rec] = field->Intern(value);
+        }
+    }
+
+    void CachedGatePBStep::GotoFirst()
+    {
+        currentRecIndex_ = 0;
+    }
+
+    void CachedGatePBStep::GotoNext()
+    {
+        ++currentRecIndex_;
+    }
+
+    std::pair<const char *, int> CachedGatePBStep::FindItem(int stepid)
+    {
+        EnsureDecompressed();
+        if (currentRecIndex_ < 0 || currentRecIndex_ >= static_cast<int>(bodyRecords_.size()))
+        { // 无包体记录
             return {nullptr, 0};
         }
 
-        const char *valueEnd = ::strstr(valPtr, "&");
-        int len = 0;
-        if (valueEnd == nullptr) // 最后一个字段
+        const RecordInfo &record = bodyRecords_[currentRecIndex_];
+        if (record.data == nullptr)
+        { // 记录尚未添加记录
+            return {nullptr, 0};
+        }
+
+        // 先查补丁，再只在记录长度内查找
+        Span value = FindPatch(currentRecIndex_, stepid);
+        if (value.data == nullptr)
         {
-            len = limitedLen - (valPtr - begin);
+            value = FindField(Span(record.data, record.length), stepid);
         }
-        else
+        return std::make_pair(value.data, static_cast<int>(value.size));
+    }
+
+    size_t CachedGatePBStep::GetFields(const int *ids, size_t n, Span *out) const
+    {
+        CheckDecompressed();
+        if (currentRecIndex_ < 0 || currentRecIndex_ >= static_cast<int>(bodyRecords_.size()) ||
+            bodyRecords_[currentRecIndex_].data == nullptr)
         {
-            len = valueEnd - valPtr;
+            return stepver2::GetFields(Span(), ids, n, out);
         }
 
-        return std::make_pair(valPtr, len);
+        const RecordInfo &record = bodyRecords_[currentRecIndex_];
+        size_t found = stepver2::GetFields(Span(record.data, record.length), ids, n, out);
+        if (record.patchHead >= 0)
+        {
+            ApplyPatches(currentRecIndex_, ids, n, out);
+            found = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                found += (out[i].data != nullptr);
+            }
+        }
+        return found;
     }
 
     std::pair<const char *, int> CachedGatePBStep::FindItemByBuffer(int stepid)
@@ -305,8 +701,26 @@ namespace stepver2
         return "";
     }
 
-    std::string CachedGatePBStep::GetBaseFieldValue(int stepid)
+    std::string CachedGatePBStep::GetBaseFieldValue(int stepid) const
     {
+        if (inlineBase_)
+        {
+            for (size_t i = 0; i < inlineBaseCount_; ++i)
+            {
+                const auto &field = inlineBaseFields_[i];
+                if (field.stepid == stepid)
+                {
+                    const char *value = inlinePackage_ + field.offset;
+                    if (NeedEscapeBack(Span(value, field.length)))
+                    {
+                        return EscapeBackItem(std::string(value, field.length));
+                    }
+                    return std::string(value, field.length);
+                }
+            }
+            return "";
+        }
+
         auto it = baseRecord_.find(stepid);
         if (it != baseRecord_.end())
             return it->second;
@@ -314,56 +728,347 @@ namespace stepver2
         return "";
     }
 
+    // 废弃数据少于该值时不压缩，避免小包频繁搬移
+    static const size_t s_MinCompactBytes = 4096;
+
     bool CachedGatePBStep::SetFieldValue(int stepid, const char *value)
     {
-        if (currentRecIndex_ < 0 || bodyRecords_.empty())
+        EnsureDecompressed();
+        if (currentRecIndex_ < 0 || currentRecIndex_ >= static_cast<int>(bodyRecords_.size()))
         {
             return false; // 包体为空时，设置值失败
         }
 
-        int recSize = bodyRecords_[currentRecIndex_].length;
-        if (recSize == 0)
+        RecordInfo &record = bodyRecords_[currentRecIndex_];
+        if (record.data == nullptr || record.length == 0)
         {
             return false;
         }
 
-        std::string currRec{"&"};
-        currRec.append(bodyRecords_[currentRecIndex_].data, recSize);
-        char key[16];
-        sprintf(key, "&%d=", stepid);
-        size_t pos = currRec.find(key);
-        if (pos == currRec.npos)
+        static const char s_EmptyValue[] = "";
+        size_t valueLen = (value == nullptr) ? 0 : ::strlen(value);
+        const char *valuePtr = s_EmptyValue;
+        try
         {
-            currRec += key;
-            currRec += value;
-            currRec += '&';
+            if (valueLen > 0)
+            {
+                valuePtr = memoryPool_.Allocate(value, valueLen);
+            }
         }
-        else
+        catch (const std::exception &)
+        {
+            return false;
+        }
+
+        // 已有补丁则替换补丁值，旧值成为废弃数据
+        int *link = &record.patchHead;
+        for (; *link >= 0; link = &patches_[*link].next)
+        {
+            FieldPatch &patch = patches_[*link];
+            if (patch.stepid == stepid)
+            {
+                deadBytes_ += patch.length;
+                patch.data = valuePtr;
+                patch.length = static_cast<int>(valueLen);
+                UpdateInterned(currentRecIndex_, stepid, Span(valuePtr, valueLen));
+
+                if (deadBytes_ >= s_MinCompactBytes && deadBytes_ > compactRatio_ * memoryPool_.GetTotalUsedSize())
+                {
+                    Compact();
+                }
+                return true;
+            }
+        }
+
+        // 新补丁：记录中有该字段则替换第一个，否则追加在记录末尾
+        Span current = FindField(Span(record.data, record.length), stepid);
+        FieldPatch patch;
+        patch.stepid = stepid;
+        patch.replaceOffset = (current.data == nullptr) ? -1 : static_cast<int>(current.data - record.data);
+        patch.data = valuePtr;
+        patch.length = static_cast<int>(valueLen);
+        patch.next = -1;
+
+        *link = static_cast<int>(patches_.size());
+        patches_.push_back(patch);
+        UpdateInterned(currentRecIndex_, stepid, Span(valuePtr, valueLen));
+        return true;
+    }
+
+    Span CachedGatePBStep::FindPatch(size_t rec, int stepid) const
+    {
+        for (int i = bodyRecords_[rec].patchHead; i >= 0; i = patches_[i].next)
         {
-            std::string newStr = currRec.substr(0, pos + strlen(key));
-            newStr += value;
+            if (patches_[i].stepid == stepid)
+            {
+                return Span(patches_[i].data, patches_[i].length);
+            }
+        }
+        return Span();
+    }
+
+    void CachedGatePBStep::ApplyPatches(size_t rec, const int *ids, size_t n, Span *out) const
+    {
+        for (int i = bodyRecords_[rec].patchHead; i >= 0; i = patches_[i].next)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (ids[j] == patches_[i].stepid)
+                {
+                    out[j] = Span(patches_[i].data, patches_[i].length);
+                }
+            }
+        }
+    }
 
-            size_t nextPos = currRec.find('&', pos + 1);
-            if (nextPos != currRec.npos)
+    void CachedGatePBStep::AppendPatchedRecord(std::string &out, size_t rec) const
+    {
+        const RecordInfo &record = bodyRecords_[rec];
+        if (record.patchHead < 0)
+        {
+            if (record.data != nullptr)
             {
-                newStr.append(currRec.substr(nextPos));
+                out.append(record.data, record.length);
             }
+            return;
+        }
 
-            currRec = std::move(newStr);
+        ForEachRecordField(rec, [&out](int stepid, Span value)
+                           {
+                               fmt::format_int id(stepid);
+                               out.append(id.data(), id.size());
+                               out.push_back('=');
+                               out.append(value.data, value.size);
+                               out.push_back('&');
+                           });
+    }
+
+    void CachedGatePBStep::Compact()
+    {
+        if (patches_.empty() && deadBytes_ == 0)
+        {
+            return;
         }
 
-        // 重新分配内存存储修改后的记录
-        try
+        MemoryPool pool(memoryPool_.GetBackend());
+        pool.Reserve(memoryPool_.GetTotalUsedSize() - deadBytes_);
+
+        std::string buffer;
+        for (size_t i = 0; i < bodyRecords_.size(); ++i)
         {
-            char *newPtr = memoryPool_.Allocate(currRec.data() + 1, currRec.size() - 1);
-            bodyRecords_[currentRecIndex_].data = newPtr;
-            bodyRecords_[currentRecIndex_].length = currRec.size();
-            return true;
+            RecordInfo &record = bodyRecords_[i];
+            if (record.data == nullptr || record.length == 0)
+            {
+                continue;
+            }
+
+            buffer.clear();
+            AppendPatchedRecord(buffer, i);
+            record.data = pool.Allocate(buffer.data(), buffer.size());
+            record.length = static_cast<int>(buffer.size());
+            record.patchHead = -1;
         }
-        catch (const std::exception &)
+
+        memoryPool_ = std::move(pool);
+        sharedPools_.clear();
+        patches_.clear();
+        deadBytes_ = 0;
+        RebuildInterned();
+    }
+
+    bool CachedGatePBStep::Compress()
+    {
+        if (IsCompressed() || bodyRecords_.empty() ||
+            (bodyRecords_.front().data != nullptr && IsInlineData(bodyRecords_.front().data)))
         {
             return false;
         }
+
+        std::vector<CompressedChunk> chunks;
+        std::string raw;
+        std::string packed;
+        raw.reserve(STEPVER2_COMPRESS_CHUNK_SIZE * 2);
+        uint32_t records = 0;
+        for (size_t i = 0; i < bodyRecords_.size(); ++i)
+        {
+            AppendPatchedRecord(raw, i);
+            raw.push_back('\n');
+            ++records;
+
+            if (raw.size() >= STEPVER2_COMPRESS_CHUNK_SIZE || i + 1 == bodyRecords_.size())
+            {
+                LzCompress(raw.data(), raw.size(), packed);
+                // 拷贝一次，压缩块只占实际长度
+                chunks.push_back(CompressedChunk{records, static_cast<uint32_t>(raw.size()), packed});
+                raw.clear();
+                records = 0;
+            }
+        }
+
+        compressedInterned_.clear();
+        for (const auto &field : interned_.fields_)
+        {
+            compressedInterned_.push_back(field.stepid_);
+        }
+
+        chunks_.swap(chunks);
+        compressedRecords_ = bodyRecords_.size();
+        std::vector<RecordInfo>().swap(bodyRecords_);
+        std::vector<FieldPatch>().swap(patches_);
+        deadBytes_ = 0;
+        interned_.Clear();
+        sharedPools_.clear();
+        memoryPool_ = MemoryPool(memoryPool_.GetBackend());
+        return true;
+    }
+
+    void CachedGatePBStep::Decompress()
+    {
+        if (!IsCompressed())
+        {
+            return;
+        }
+
+        size_t rawSize = 0;
+        for (const auto &chunk : chunks_)
+        {
+            rawSize += chunk.rawSize;
+        }
+        memoryPool_.Reserve(rawSize);
+        bodyRecords_.reserve(compressedRecords_);
+
+        std::string buffer;
+        for (size_t i = 0; i < chunks_.size(); ++i)
+        {
+            buffer.clear();
+            AppendChunk(buffer, i);
+
+            const char *pos = buffer.data();
+            const char *end = pos + buffer.size();
+            while (pos < end)
+            {
+                const char *eol = static_cast<const char *>(::memchr(pos, '\n', end - pos));
+                RecordInfo record;
+                if (eol > pos)
+                {
+                    record = RecordInfo(memoryPool_.Allocate(pos, eol - pos), static_cast<int>(eol - pos));
+                }
+                bodyRecords_.push_back(record);
+                pos = eol + 1;
+            }
+        }
+
+        std::vector<CompressedChunk>().swap(chunks_);
+        compressedRecords_ = 0;
+        std::vector<int> stepids;
+        stepids.swap(compressedInterned_);
+        InternFields(stepids);
+    }
+
+    size_t CachedGatePBStep::CompressedSize() const
+    {
+        size_t total = 0;
+        for (const auto &chunk : chunks_)
+        {
+            total += chunk.data.size();
+        }
+        return total;
+    }
+
+    void CachedGatePBStep::AppendChunk(std::string &out, size_t index) const
+    {
+        const CompressedChunk &chunk = chunks_[index];
+        size_t offset = out.size();
+        out.resize(offset + chunk.rawSize);
+        if (!LzDecompress(chunk.data.data(), chunk.data.size(), &out[offset], chunk.rawSize))
+        {
+            throw std::runtime_error("[CachedGatePBStep]Compressed chunk is corrupted..");
+        }
+    }
+
+    size_t CachedGatePBStep::FillChunk(size_t index, std::string &out) const
+    {
+        out.clear();
+        if (IsCompressed())
+        {
+            AppendChunk(out, index);
+            return index + 1;
+        }
+
+        for (; index < bodyRecords_.size() && out.size() < STEPVER2_COMPRESS_CHUNK_SIZE; ++index)
+        {
+            AppendPatchedRecord(out, index);
+            out.push_back('\n');
+        }
+        return index;
+    }
+
+    void CachedGatePBStep::ShareMemoryPool()
+    {
+        if (memoryPool_.GetTotalUsedSize() == 0)
+        {
+            return;
+        }
+
+        sharedPools_.push_back(std::make_shared<MemoryPool>(std::move(memoryPool_)));
+        memoryPool_ = MemoryPool(sharedPools_.back()->GetBackend());
+    }
+
+    void CachedGatePBStep::Merge(CachedGatePBStep *const *sources, size_t count)
+    {
+        EnsureDecompressed();
+        long long total = View().TotalCount();
+        bool hasBase = inlineBase_ || !baseRecord_.empty();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            CachedGatePBStep *source = sources[i];
+            if (source == nullptr || source == this)
+            {
+                continue;
+            }
+
+            if (!hasBase && (source->inlineBase_ || !source->baseRecord_.empty()))
+            {
+                source->LoadInlineBase();
+                baseRecord_ = source->baseRecord_;
+                hasBase = true;
+            }
+            // 先解压，压缩期间视图中没有记录
+            source->EnsureDecompressed();
+            total += source->View().TotalCount();
+
+            // 来源包和本包共同持有内存池，来源包之前共享的内存池也一并持有
+            source->ShareMemoryPool();
+            sharedPools_.insert(sharedPools_.end(), source->sharedPools_.begin(), source->sharedPools_.end());
+
+            bodyRecords_.reserve(bodyRecords_.size() + source->bodyRecords_.size());
+            for (const RecordInfo &sourceRecord : source->bodyRecords_)
+            {
+                RecordInfo record(sourceRecord.data, sourceRecord.length);
+                if (record.data != nullptr && source->IsInlineData(record.data))
+                {
+                    record.data = memoryPool_.Allocate(record.data, record.length);
+                }
+
+                // 补丁值在共享的内存池中，只需复制补丁链
+                int last = -1;
+                for (int p = sourceRecord.patchHead; p >= 0; p = source->patches_[p].next)
+                {
+                    int index = static_cast<int>(patches_.size());
+                    patches_.push_back(source->patches_[p]);
+                    patches_.back().next = -1;
+                    (last < 0 ? record.patchHead : patches_[last].next) = index;
+                    last = index;
+                }
+                bodyRecords_.push_back(record);
+            }
+        }
+
+        SetBaseFieldValueInt(STEP_RETURNNUM, static_cast<int>(bodyRecords_.size()));
+        SetBaseFieldValueString(STEP_TOTALNUM, std::to_string(total));
+        RebuildInterned();
+        GotoFirst();
     }
 
     bool CachedGatePBStep::SetFieldValueInt(int stepid, int value)
@@ -375,11 +1080,13 @@ namespace stepver2
 
     void CachedGatePBStep::SetBaseFieldValueInt(int stepid, int value)
     {
+        LoadInlineBase();
         baseRecord_[stepid] = std::to_string(value);
     }
 
     void CachedGatePBStep::SetBaseFieldValueString(int stepid, const std::string &value)
     {
+        LoadInlineBase();
         baseRecord_[stepid] = value; // 直接存储原始值，与ParseBaseRecord保持一致
     }
 
@@ -403,6 +1110,17 @@ namespace stepver2
         return result;
     }
 
+    bool CachedGatePBStep::NeedEscape(const std::string &src)
+    {
+        // 与s_EscapeItemMap的键一致
+        return src.find_first_of("\\=&\n") != std::string::npos;
+    }
+
+    bool CachedGatePBStep::NeedEscapeBack(Span raw)
+    {
+        return raw.data != nullptr && ::memchr(raw.data, '\\', raw.size) != nullptr;
+    }
+
     std::string CachedGatePBStep::EscapeBackItem(const std::string &src)
     {
         if (src.empty() || src.size() < 2)
@@ -6,27 +6,88 @@
 #pragma once
 
 #include "MemoryPool.h"
+#include "CapacityLearner.h"
+#include "RecordScanner.h"
+#include "ValueIndex.h"
+#include "RecordSort.h"
+#include "InternTable.h"
+#include "../Tool/WarmUp.h"
 
 #include <string>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <type_traits>
 #include <assert.h>
 #include <stdexcept>
+#include <sys/uio.h>
 
 #include <fmt/format.h>
 
+// 不超过该长度的请求包直接存放在对象内部，解包不占用内存池
+#ifndef STEPVER2_INLINE_PACKAGE_SIZE
+#define STEPVER2_INLINE_PACKAGE_SIZE 1024
+#endif
+
+// 内联包头可索引的字段数，超出时包头退回到map存储
+#ifndef STEPVER2_INLINE_BASE_FIELDS
+#define STEPVER2_INLINE_BASE_FIELDS 32
+#endif
+
+// Compress时每个压缩块的原始字节数，块越大压缩率越高，按块解压的延迟也越大
+#ifndef STEPVER2_COMPRESS_CHUNK_SIZE
+#define STEPVER2_COMPRESS_CHUNK_SIZE 65536
+#endif
+
 namespace stepver2
 {
+    class PackageView;
+    class PackageFrames;
+    class ColumnSet;
+    struct ColumnSpec;
+
     class CachedGatePBStep
     {
+        friend class PackageView;
+        friend class RecordRef;
+        friend class RecordCursor;
+        friend class ValueIndex;
+        friend class RecordFilter;
+        friend class PackageFrames;
+        friend class ColumnSet;
+        friend class InternedField;
+
     public:
-        CachedGatePBStep(); // 0表示使用默认值，从最低档开始
+        // backend 指定内存池的内存来源，超大结果集可选用HugePage
+        explicit CachedGatePBStep(PoolBackend backend = PoolBackend::Heap);
         virtual ~CachedGatePBStep() = default;
 
         void Init();
 
+        /**
+         * @brief 启动预热：按预期负载预留内存池、记录索引和临时缓存，并预取页面
+         * 会清空当前数据，一般在服务启动时调用
+         */
+        WarmUpReport WarmUp(const WarmUpProfile &profile);
+
+        /**
+         * @brief 开始组装应答：清空数据、设置功能号，并按该功能号的历史规模预分配容量
+         * ToString时会把本次应答的实际规模反馈给容量学习器
+         */
+        void BeginResponse(int funcid);
+
+        /**
+         * @brief 已知记录数时给出容量提示，一次性预留记录索引、内存池和输出缓存
+         * @param count 预期记录数
+         * @param avgBytes 单条记录的平均字节数
+         */
+        void ExpectRecords(size_t count, size_t avgBytes);
+
+        // 设置容量学习器，默认使用 CapacityLearner::Default()，传nullptr关闭学习
+        void SetCapacityLearner(CapacityLearner *learner) { capacityLearner_ = learner; }
+
         /*对于字符的转义，需要注意：
          * 1. 存入内存中的数据必须是转义过的数据，否则内存中的数据无法被正确查找
          * 2. 从内存中查找Get到的数据，需要做反转义的操作，才是准确的数据
@@ -61,21 +122,150 @@ namespace stepver2
             }
         }
 
+        /* 修改当前记录的字段值(value不做转义)
+         * 修改记录在补丁表中，不重写记录本身；查找时先查补丁，序列化时合并输出。
+         * 同一字段反复修改时旧值成为废弃数据，占内存池的比例超过压缩阈值后自动压缩
+         */
         bool SetFieldValue(int stepid, const char *value) __attribute__((__warn_unused_result__));
         bool SetFieldValueInt(int stepid, int value) __attribute__((__warn_unused_result__));
+
+        /**
+         * @brief 把补丁合并回记录，并把所有记录搬到新的内存池，回收废弃数据
+         * 会使已获取的 PackageView 和 Span 失效
+         */
+        void Compact();
+        // 废弃数据占内存池已用空间的比例超过ratio时自动压缩，默认0.5
+        void SetCompactThreshold(double ratio) { compactRatio_ = ratio; }
+        // 废弃数据的字节数
+        size_t DeadBytes() const { return deadBytes_; }
+        // 内存池已使用的字节数(含废弃数据)
+        size_t PoolUsedSize() const { return memoryPool_.GetTotalUsedSize(); }
         void SetBaseFieldValueInt(int stepid, int value);
         void SetBaseFieldValueString(int stepid, const std::string &value);
 
-        // 获取记录
+        // 获取记录；压缩状态下先解压整个包，之后保持解压状态
         std::string GetStepValueByID(int stepid);
-        std::string GetBaseFieldValue(int stepid);
+        std::string GetBaseFieldValue(int stepid) const;
+
+        /**
+         * @brief 一次扫描当前记录取出多个字段，代替逐个调用GetStepValueByID
+         * @param out 输出，与ids一一对应，为转义状态的原始数据，未找到的data为nullptr
+         * @return 找到的字段个数
+         */
+        size_t GetFields(const int *ids, size_t n, Span *out) const;
 
         void GotoFirst();
         void GotoNext();
 
         int RecordsCount() const
         {
-            return static_cast<int>(bodyRecords_.size());
+            return static_cast<int>(IsCompressed() ? compressedRecords_ : bodyRecords_.size());
+        }
+
+        /**
+         * @brief 只读视图，见 PackageView.h
+         * 视图和它的游标不依赖 currentRecIndex_，多个线程可各持一个游标并发读取；
+         * 本对象被修改后视图失效
+         */
+        PackageView View() const;
+
+        /**
+         * @brief 按stepid的值建立记录索引，见 ValueIndex.h
+         * 用于按值反复查找记录，如按合约代码关联合约字典；值不拷贝，本对象被修改后索引失效
+         */
+        ValueIndex BuildIndex(int stepid, ValueIndex::Mode mode = ValueIndex::Mode::Unique) const;
+
+        /**
+         * @brief 按stepid的值对记录排序，只重排记录索引，不拷贝记录数据，补丁随记录移动
+         * 没有该字段(数值排序时还包括非数字)的记录按原顺序排在最后，值相等的保持原顺序；
+         * 排序后回到第一条记录，已获取的 PackageView 和 ValueIndex 失效
+         */
+        void SortBy(int stepid, SortKey key = SortKey::Lexical, SortOrder order = SortOrder::Asc);
+        // 只保留排序后的前k条记录，其余记录从索引中去掉(数据仍在内存池中)
+        void TopK(int stepid, size_t k, SortKey key = SortKey::Lexical, SortOrder order = SortOrder::Asc);
+
+        /**
+         * @brief 把其他包的记录接在本包之后，只追加记录索引，不拷贝记录数据
+         * 来源包的内存池转为共享，由本包和来源包共同持有，来源包仍可照常读取和修改；
+         * 内联存放的小包记录直接拷贝，SetFieldValue的修改随记录带过来。
+         * 本包没有包头时使用第一个来源包的包头，STEP_RETURNNUM更新为合并后的记录数，
+         * STEP_TOTALNUM为各包总记录数之和(没有该字段的包按记录数计)；来源为本包或nullptr时忽略
+         */
+        void Merge(CachedGatePBStep *const *sources, size_t count);
+
+        // step.Merge(a, b, c)
+        template <class... Steps>
+        void Merge(CachedGatePBStep &first, Steps &...rest)
+        {
+            CachedGatePBStep *sources[] = {&first, &rest...};
+            Merge(sources, sizeof...(Steps) + 1);
+        }
+
+        /**
+         * @brief 按最大帧长把包切分为连续的若干个包，见 PackageFrames.h
+         * 按记录长度计算，不拼接中间字符串；每个包的STEP_RETURNNUM为本包记录数，其余包头字段不变
+         * @return 有记录加上包头仍超过maxBytes时返回false
+         */
+        bool SplitBySize(size_t maxBytes, PackageFrames &frames) const __attribute__((__warn_unused_result__));
+
+        /**
+         * @brief 把指定字段取到按列存放的数组中，见 ColumnSet.h
+         * 每条记录只扫描一次，数值只解析一次；字段值已合并SetFieldValue的修改
+         */
+        ColumnSet ToColumns(const std::vector<ColumnSpec> &specs) const;
+        /**
+         * @brief 按行把列追加为记录，每行一条记录，空值的字段不输出
+         * 字符串列的字典项只转义一次
+         */
+        void AppendColumns(const ColumnSet &columns);
+
+        /**
+         * @brief 为指定字段建立包内字典，见 InternTable.h
+         * 用于市场代码、币种、状态标志等大量重复的字段，之后筛选和按列读取这些字段时比较编码而不是字符串；
+         * 记录数据保持不变
+         */
+        void InternFields(const std::vector<int> &stepids);
+        const InternTable &Interned() const { return interned_; }
+
+        /**
+         * @brief 压缩已完成的包，用于长期缓存的应答
+         * 合并补丁后按 STEPVER2_COMPRESS_CHUNK_SIZE 把记录分块，每块用 LzCodec.h 压缩，释放内存池和记录索引；
+         * 包头不压缩。ToString、FormatedRecords、StreamTo 逐块解压输出，不恢复记录；
+         * GetStepValueByID、SetFieldValue、AppendRecord、排序、合并、InternFields 先把整个包解压回内存池，
+         * 不是只解压当前记录所在的块，之后保持解压状态，需要时再调用Compress。
+         * 压缩期间 View、GetFields、BuildIndex、ToColumns(以及基于它们的 RecordFilter::Apply、Summarize、
+         * SummarizeBy、SortedMerge::Add)抛出 std::logic_error，SplitBySize 返回false，需先调用Decompress
+         * @return 已经压缩、没有记录或是内联的小包时返回false
+         */
+        bool Compress();
+        // 解压回内存池，之前建立的包内字典随之重建；未压缩时什么也不做
+        void Decompress();
+        bool IsCompressed() const { return !chunks_.empty(); }
+        // 压缩块占用的字节数，未压缩时为0
+        size_t CompressedSize() const;
+
+        /**
+         * @brief 按块输出序列化结果，与ToString内容相同，sink(const struct iovec *iov, int count)，可直接writev
+         * 先输出包头，之后每块不超过约 STEPVER2_COMPRESS_CHUNK_SIZE 字节；
+         * 压缩状态下逐块解压到同一个缓存，不展开整个包。iov只在sink调用期间有效
+         */
+        template <class Sink>
+        void StreamTo(Sink &&sink) const
+        {
+            std::string buffer = BaseRecord();
+            struct iovec iov;
+            iov.iov_base = &buffer[0];
+            iov.iov_len = buffer.size();
+            sink(static_cast<const struct iovec *>(&iov), 1);
+
+            size_t count = IsCompressed() ? chunks_.size() : bodyRecords_.size();
+            for (size_t next = 0; next < count;)
+            {
+                next = FillChunk(next, buffer);
+                iov.iov_base = &buffer[0];
+                iov.iov_len = buffer.size();
+                sink(static_cast<const struct iovec *>(&iov), 1);
+            }
         }
 
     protected:
@@ -88,10 +278,98 @@ namespace stepver2
         static std::string EscapeBackItem(const std::string &src);
         // 转义字段
         static std::string EscapeItem(const std::string &src);
+        // 是否含有需要转义的字符，按值查找时据此决定是否先转义
+        static bool NeedEscape(const std::string &src);
+        // 原始值是否含有转义序列，读取时据此决定是否反义
+        static bool NeedEscapeBack(Span raw);
 
         // 不带转义
         std::string GetItem(int stepid);
 
+        // 把内存池转为共享，之后的分配使用新的内存池
+        void ShareMemoryPool();
+        // 数据是否存放在内联缓存中
+        bool IsInlineData(const char *data) const
+        {
+            return data >= inlinePackage_ && data < inlinePackage_ + sizeof(inlinePackage_);
+        }
+
+        // 按预期的记录数和包体长度预分配记录索引、内存池和输出缓存
+        void Presize(size_t records, size_t bytes);
+
+        // 第rec条记录中stepid的补丁值，没有补丁时data为nullptr
+        Span FindPatch(size_t rec, int stepid) const;
+        // 每条记录中stepid的值(优先取补丁)，没有该字段的data为nullptr
+        std::vector<Span> FieldValues(int stepid) const;
+        // 按已建立字典的字段重新建立字典，记录数据搬移或增加后调用
+        void RebuildInterned();
+        // 第rec条记录的stepid修改为value后更新编码
+        void UpdateInterned(size_t rec, int stepid, Span value);
+        // 按排序结果重排记录索引，只保留前limit条
+        void Reorder(int stepid, SortKey key, SortOrder order, size_t limit);
+        // 用补丁覆盖GetFields的结果
+        void ApplyPatches(size_t rec, const int *ids, size_t n, Span *out) const;
+        // 输出合并补丁后的第rec条记录(不含换行)
+        void AppendPatchedRecord(std::string &out, size_t rec) const;
+        // 把第index个压缩块解压追加到out
+        void AppendChunk(std::string &out, size_t index) const;
+        // StreamTo的一块：压缩时解压第index块，否则从第index条起取记录到约一块大小；返回下一块的起点
+        size_t FillChunk(size_t index, std::string &out) const;
+        void EnsureDecompressed()
+        {
+            if (IsCompressed())
+            {
+                Decompress();
+            }
+        }
+        // const接口不能解压，压缩期间直接读取记录时抛出异常
+        void CheckDecompressed() const
+        {
+            if (IsCompressed())
+            {
+                throw std::logic_error("[CachedGatePBStep]Records are compressed, call Decompress first..");
+            }
+        }
+
+        /**
+         * @brief 按合并补丁后的内容访问第rec条记录的字段
+         * 被修改的字段在原位置输出新值，新增的字段按修改顺序追加在最后
+         */
+        template <class Fn>
+        void ForEachRecordField(size_t rec, Fn &&fn) const
+        {
+            const RecordInfo &record = bodyRecords_[rec];
+            const char *pos = record.data;
+            const char *end = record.data + (record.data == nullptr ? 0 : record.length);
+            int stepid = 0;
+            Span value;
+            while (NextField(pos, end, stepid, value))
+            {
+                for (int i = record.patchHead; i >= 0; i = patches_[i].next)
+                {
+                    if (patches_[i].replaceOffset == value.data - record.data)
+                    {
+                        value = Span(patches_[i].data, patches_[i].length);
+                        break;
+                    }
+                }
+                fn(stepid, value);
+            }
+
+            for (int i = record.patchHead; i >= 0; i = patches_[i].next)
+            {
+                if (patches_[i].replaceOffset < 0)
+                {
+                    fn(patches_[i].stepid, Span(patches_[i].data, patches_[i].length));
+                }
+            }
+        }
+
+        // 在内联缓存中建立包头字段索引，字段过多时返回false
+        bool IndexInlineBase(size_t baseLen);
+        // 将内联的包头字段转存到baseRecord_，修改包头前调用
+        void LoadInlineBase();
+
     protected:
         //<id, val>
         std::map<int, std::string> baseRecord_;
@@ -99,17 +377,49 @@ namespace stepver2
         // 记录信息结构体
         struct RecordInfo
         {
-            char *data; // 数据指针
-            int length; // 数据长度
+            char *data;     // 数据指针
+            int length;     // 数据长度
+            int patchHead;  // 第一个补丁在patches_中的下标，-1表示没有修改
 
-            RecordInfo() : data(nullptr), length(0) {}
-            RecordInfo(char *d, int l) : data(d), length(l) {}
+            RecordInfo() : data(nullptr), length(0), patchHead(-1) {}
+            RecordInfo(char *d, int l) : data(d), length(l), patchHead(-1) {}
         };
 
         // body 存储的内容格式还是 id=value&id=value
         std::vector<RecordInfo> bodyRecords_;
 
         MemoryPool memoryPool_;
+        // 重复字段值的包内字典
+        InternTable interned_;
+        // Merge后与其他包共同持有的内存池，记录可能指向其中；Init或Compact时释放
+        std::vector<std::shared_ptr<MemoryPool>> sharedPools_;
+
+        // SetFieldValue的补丁，同一记录的补丁按修改顺序链接
+        struct FieldPatch
+        {
+            int stepid;
+            int replaceOffset; // 被替换的值在记录中的偏移，-1表示追加在记录末尾
+            const char *data;  // 补丁值，存放在内存池中
+            int length;
+            int next;          // 同一记录的下一个补丁，-1表示结束
+        };
+        std::vector<FieldPatch> patches_;
+
+        // Compress后的记录块，记录为合并补丁后的内容，每条以换行结尾
+        struct CompressedChunk
+        {
+            uint32_t records;
+            uint32_t rawSize;
+            std::string data;
+        };
+        std::vector<CompressedChunk> chunks_;
+        size_t compressedRecords_ = 0;
+        // 压缩前建立过字典的字段，解压后重建
+        std::vector<int> compressedInterned_;
+
+        // 被覆盖的补丁值占用的内存池字节数
+        size_t deadBytes_ = 0;
+        double compactRatio_ = 0.5;
 
         // 包体的当前记录索引, 没有记录时必须为-1
         int currentRecIndex_ = -1;
@@ -120,5 +430,32 @@ namespace stepver2
          * 2) 通过AddFieldValue添加记录时，作为临时缓存，每添加完一条记录，就会清空该缓存来准备下一条记录的添加。这种情况，该字段不适用于查询
          */
         std::string tmpBuffer_;
+
+        // 预期的包体序列化长度，ToString据此预留输出缓存，0表示未知
+        size_t expectedOutputSize_ = 0;
+
+        CapacityLearner *capacityLearner_ = &CapacityLearner::Default();
+        // 通过BeginResponse开始的应答功能号，ToString后反馈规模，-1表示不学习
+        int learningFuncId_ = -1;
+
+        /* 小包内联存储
+         * 不超过 STEPVER2_INLINE_PACKAGE_SIZE 的包由SetPackage整包拷贝到 inlinePackage_，
+         * 包体记录直接指向这里，包头只建立字段索引，读取时才反转义；
+         * 修改包头时再转存到 baseRecord_
+         */
+        struct InlineField
+        {
+            int stepid;
+            uint16_t offset;
+            uint16_t length;
+        };
+        static_assert(STEPVER2_INLINE_PACKAGE_SIZE <= UINT16_MAX, "inline offsets are 16-bit");
+
+        // 包头字段是否仍在内联索引中
+        bool inlineBase_ = false;
+        size_t inlineBaseCount_ = 0;
+        InlineField inlineBaseFields_[STEPVER2_INLINE_BASE_FIELDS];
+
+        char inlinePackage_[STEPVER2_INLINE_PACKAGE_SIZE];
     };
 }
@@ -0,0 +1,146 @@
+#include "ValueIndex.h"
+#include "StepVer2.h"
+
+#include <cstring>
+
+namespace stepver2
+{
+    uint64_t ValueIndex::Hash(const char *data, size_t len)
+    {
+        return HashBytes(data, len);
+    }
+
+    void ValueIndex::Build(const std::vector<Span> &values, Mode mode)
+    {
+        mode_ = mode;
+        size_ = 0;
+        duplicates_ = 0;
+        rows_.clear();
+
+        // 负载因子不超过0.5
+        size_t capacity = 16;
+        while (capacity < values.size() * 2)
+        {
+            capacity <<= 1;
+        }
+        slots_.assign(capacity, Slot());
+        const size_t mask = capacity - 1;
+
+        // 第一遍：插入键并计数，记录每条记录所在的槽位
+        std::vector<uint32_t> slotOfRow(values.size(), UINT32_MAX);
+        for (size_t row = 0; row < values.size(); ++row)
+        {
+            const Span &value = values[row];
+            if (value.data == nullptr)
+            {
+                continue;
+            }
+
+            uint64_t hash = Hash(value.data, value.size);
+            size_t pos = hash & mask;
+            while (slots_[pos].count != 0)
+            {
+                const Slot &slot = slots_[pos];
+                if (slot.hash == hash && slot.key.size == value.size &&
+                    ::memcmp(slot.key.data, value.data, value.size) == 0)
+                {
+                    break;
+                }
+                pos = (pos + 1) & mask;
+            }
+
+            Slot &slot = slots_[pos];
+            if (slot.count == 0)
+            {
+                slot.key = value;
+                slot.hash = hash;
+                ++size_;
+            }
+            else if (mode == Mode::Unique)
+            {
+                ++duplicates_;
+                continue;
+            }
+            ++slot.count;
+            slotOfRow[row] = static_cast<uint32_t>(pos);
+        }
+
+        // 第二遍：按槽位分配记录序号的存放区间，再按记录顺序填入
+        uint32_t offset = 0;
+        for (auto &slot : slots_)
+        {
+            slot.begin = offset;
+            offset += slot.count;
+        }
+
+        rows_.resize(offset);
+        std::vector<uint32_t> filled(capacity, 0);
+        for (size_t row = 0; row < values.size(); ++row)
+        {
+            uint32_t pos = slotOfRow[row];
+            if (pos != UINT32_MAX)
+            {
+                rows_[slots_[pos].begin + filled[pos]++] = static_cast<uint32_t>(row);
+            }
+        }
+    }
+
+    long ValueIndex::FindSlot(Span raw) const
+    {
+        if (slots_.empty() || raw.data == nullptr)
+        {
+            return -1;
+        }
+
+        const size_t mask = slots_.size() - 1;
+        uint64_t hash = Hash(raw.data, raw.size);
+        for (size_t pos = hash & mask; slots_[pos].count != 0; pos = (pos + 1) & mask)
+        {
+            const Slot &slot = slots_[pos];
+            if (slot.hash == hash && slot.key.size == raw.size &&
+                (raw.size == 0 || ::memcmp(slot.key.data, raw.data, raw.size) == 0))
+            {
+                return static_cast<long>(pos);
+            }
+        }
+        return -1;
+    }
+
+    int ValueIndex::FindRaw(Span raw) const
+    {
+        long pos = FindSlot(raw);
+        return pos < 0 ? -1 : static_cast<int>(rows_[slots_[pos].begin]);
+    }
+
+    int ValueIndex::Find(const std::string &value) const
+    {
+        if (CachedGatePBStep::NeedEscape(value))
+        {
+            std::string escaped = CachedGatePBStep::EscapeItem(value);
+            return FindRaw(Span(escaped.data(), escaped.size()));
+        }
+        return FindRaw(Span(value.data(), value.size()));
+    }
+
+    std::pair<const uint32_t *, const uint32_t *> ValueIndex::FindAllRaw(Span raw) const
+    {
+        long pos = FindSlot(raw);
+        if (pos < 0)
+        {
+            return std::make_pair(nullptr, nullptr);
+        }
+
+        const uint32_t *begin = rows_.data() + slots_[pos].begin;
+        return std::make_pair(begin, begin + slots_[pos].count);
+    }
+
+    std::pair<const uint32_t *, const uint32_t *> ValueIndex::FindAll(const std::string &value) const
+    {
+        if (CachedGatePBStep::NeedEscape(value))
+        {
+            std::string escaped = CachedGatePBStep::EscapeItem(value);
+            return FindAllRaw(Span(escaped.data(), escaped.size()));
+        }
+        return FindAllRaw(Span(value.data(), value.size()));
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * @Description: 按字段值查找记录的二级索引，开放寻址哈希表，键直接引用记录数据不拷贝
+ * @Author: yubo
+ * @Date: 2025-02-24
+ */
+#pragma once
+
+#include "RecordScanner.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stepver2
+{
+    /**
+     * @brief 字段值到记录序号的索引，通过 CachedGatePBStep::BuildIndex 建立
+     * 键是记录中转义状态的原始值，查找时传入的值会按同样规则转义；
+     * 索引引用来源对象的数据，来源对象被修改(Init、SetPackage、SetFieldValue、Compact等)后失效
+     */
+    class ValueIndex
+    {
+    public:
+        enum class Mode
+        {
+            Unique, // 每个值只保留第一条记录
+            Multi   // 每个值保留所有记录，按记录顺序
+        };
+
+        ValueIndex() = default;
+
+        Mode GetMode() const { return mode_; }
+        // 不同值的个数
+        size_t Size() const { return size_; }
+        // Unique模式下被忽略的重复记录数
+        size_t Duplicates() const { return duplicates_; }
+
+        // 值等于value的第一条记录序号，未找到返回-1
+        int Find(const std::string &value) const;
+        int FindRaw(Span raw) const;
+
+        // 值等于value的所有记录序号，按记录顺序；Unique模式下最多一条
+        std::pair<const uint32_t *, const uint32_t *> FindAll(const std::string &value) const;
+        std::pair<const uint32_t *, const uint32_t *> FindAllRaw(Span raw) const;
+
+    private:
+        friend class CachedGatePBStep;
+        friend class ColumnSet;
+
+        /**
+         * @brief 建立索引
+         * @param values 第i个元素为第i条记录的值，data为nullptr表示该记录没有这个字段
+         */
+        void Build(const std::vector<Span> &values, Mode mode);
+
+        // 查找键所在的槽位，未找到返回-1
+        long FindSlot(Span raw) const;
+
+        static uint64_t Hash(const char *data, size_t len);
+
+    private:
+        struct Slot
+        {
+            Span key;
+            uint64_t hash = 0;
+            uint32_t begin = 0; // 在rows_中的起始位置
+            uint32_t count = 0; // 0表示空槽位
+        };
+
+        Mode mode_ = Mode::Unique;
+        size_t size_ = 0;
+        size_t duplicates_ = 0;
+
+        // 槽位数为2的幂
+        std::vector<Slot> slots_;
+        // 按值分组的记录序号
+        std::vector<uint32_t> rows_;
+    };
+}
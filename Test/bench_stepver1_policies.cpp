@@ -0,0 +1,146 @@
+/*
+ * @Description: StepVer1 各存储策略的统一性能测试
+ * @Author: yubo
+ * @Date: 2025-02-18
+ */
+
+#include "../StepVer1/MultiRecordStream.h"
+#include "../StepVer1/MultiRecordStreamWithPool.h"
+#include "../StepVer1/MultiRecordStreamWithMem.h"
+#include "../StepVer1/MultiRecordStreamWithArena.h"
+#include "stepdef.h"
+#include <iostream>
+#include <chrono>
+#include <cassert>
+
+using namespace step;
+
+// 按stepid升序添加字段，各存储策略的序列化结果应完全一致
+template <class Stream>
+std::string FillStream(Stream &stream, int recordCount)
+{
+    stream.Init();
+    stream.SetBaseFieldValueString(STEP_FUNC, "1001");
+    stream.ExpectRecords(recordCount, 96);
+
+    for (int i = 0; i < recordCount; ++i)
+    {
+        stream.AppendRecord();
+        stream.AddFieldValue(STEP_SCDM, (i % 2 == 0) ? "SH" : "SZ");
+        stream.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        stream.AddFieldValue(STEP_HYCS, 100 + i);
+        stream.AddFieldValue(STEP_ZXBDJW, 0.01);
+        stream.AddFieldValue(STEP_WTSX, 1000 + i * 10);
+        stream.AddFieldValue(STEP_XQJG, 10.0 + i * 0.1);
+        stream.AddFieldValue(STEP_DWBZJ, 1000.0 + i * 0.5);
+        stream.EndAppendRecord();
+    }
+
+    return stream.ToSerialized();
+}
+
+template <class Stream>
+std::string BenchPolicy(const char *name, int recordCount, int rounds)
+{
+    Stream stream;
+    std::string serialized;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        serialized = FillStream(stream, recordCount);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    assert(stream.RecordsCount() == static_cast<size_t>(recordCount));
+
+    std::cout << "  " << name << ": " << duration.count() / rounds << " microseconds/round, "
+              << serialized.size() << " bytes" << std::endl;
+    return serialized;
+}
+
+// 反序列化后逐条读取字段，并验证序列化结果不变
+template <class Stream>
+void BenchDeserialize(const char *name, const std::string &serialized, int recordCount, int rounds)
+{
+    Stream stream;
+    size_t checksum = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        bool ok = stream.DoDeserialize(serialized);
+        assert(ok);
+        (void)ok;
+        for (size_t i = 0; i < stream.RecordsCount(); ++i)
+        {
+            checksum += stream.GetFieldRaw(i, STEP_HYDM).second;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    assert(stream.RecordsCount() == static_cast<size_t>(recordCount));
+    assert(stream.GetBaseFieldValue(STEP_FUNC) == "1001");
+    assert(stream.GetFieldValue(recordCount - 1, STEP_HYDM) == std::to_string(600000 + recordCount - 1));
+    assert(stream.GetFieldRaw(0, STEP_XXNR).first == nullptr);
+    assert(stream.ToSerialized() == serialized);
+
+    std::cout << "  " << name << ": " << duration.count() / rounds << " microseconds/round (deserialize), checksum "
+              << checksum << std::endl;
+}
+
+// 含转义字符的字段读取时反转义
+template <class Stream>
+void CheckEscapedField()
+{
+    Stream stream;
+    stream.Init();
+    stream.SetBaseFieldValueString(STEP_FUNC, "1001");
+    stream.AppendRecord();
+    stream.AddFieldValue(STEP_HYDM, "600000");
+    stream.AddFieldValue(STEP_XXNR, "a=b&c\\d", true);
+    stream.EndAppendRecord();
+
+    Stream parsed;
+    bool ok = parsed.DoDeserialize(stream.ToSerialized());
+    assert(ok);
+    (void)ok;
+    assert(parsed.GetFieldValue(0, STEP_XXNR) == "a=b&c\\d");
+    assert(parsed.GetFieldValue(0, STEP_HYDM) == "600000");
+}
+
+int main()
+{
+    std::cout << "StepVer1 Storage Policy Benchmark" << std::endl;
+    std::cout << "=================================" << std::endl;
+
+    const int testSizes[] = {100, 1000, 10000};
+    for (int size : testSizes)
+    {
+        std::cout << "\nTesting with " << size << " records:" << std::endl;
+
+        std::string byMap = BenchPolicy<MultiRecordStream>("vector<map>", size, 5);
+        std::string byPool = BenchPolicy<MultiRecordStreamWithPool>("slab pool  ", size, 5);
+        std::string byMem = BenchPolicy<MultiRecordStreamWithMem>("memblock   ", size, 5);
+        std::string byArena = BenchPolicy<MultiRecordStreamWithArena>("arena      ", size, 5);
+
+        assert(byMap == byPool);
+        assert(byPool == byMem);
+        assert(byMem == byArena);
+
+        BenchDeserialize<MultiRecordStream>("vector<map>", byMap, size, 5);
+        BenchDeserialize<MultiRecordStreamWithPool>("slab pool  ", byMap, size, 5);
+        BenchDeserialize<MultiRecordStreamWithMem>("memblock   ", byMap, size, 5);
+        BenchDeserialize<MultiRecordStreamWithArena>("arena      ", byMap, size, 5);
+    }
+
+    CheckEscapedField<MultiRecordStream>();
+    CheckEscapedField<MultiRecordStreamWithPool>();
+    CheckEscapedField<MultiRecordStreamWithMem>();
+    CheckEscapedField<MultiRecordStreamWithArena>();
+
+    std::cout << "\nAll policies produced identical output!" << std::endl;
+    return 0;
+}
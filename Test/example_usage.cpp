@@ -5,6 +5,7 @@
  */
 
 #include "../StepVer2/StepVer2.h"
+#include "../StepVer2/PackageView.h"
 #include "stepdef.h"
 #include <iostream>
 #include <string>
@@ -129,19 +130,19 @@ void NavigationExample()
     std::cout << "总记录数: " << step.RecordsCount() << std::endl;
 
     // 遍历所有记录
-    step.GotoFirst();
-    for (int i = 0; i < step.RecordsCount(); ++i)
+    for (RecordRef record : step.View())
     {
-        std::cout << "记录 " << (i + 1) << ":" << std::endl;
-        std::cout << "  市场: " << step.GetStepValueByID(STEP_SCDM) << std::endl;
-        std::cout << "  代码: " << step.GetStepValueByID(STEP_HYDM) << std::endl;
-        std::cout << "  乘数: " << step.GetStepValueByID(STEP_HYCS) << std::endl;
-
-        if (i < step.RecordsCount() - 1)
-        {
-            step.GotoNext();
-        }
+        std::cout << "记录 " << (record.Index() + 1) << ":" << std::endl;
+        std::cout << "  市场: " << record.GetStepValueByID(STEP_SCDM) << std::endl;
+        std::cout << "  代码: " << record.GetStepValueByID(STEP_HYDM) << std::endl;
+        std::cout << "  乘数: " << record.GetStepValueByID(STEP_HYCS) << std::endl;
     }
+
+    // 不知道字段id时，按顺序列出第一条记录的所有字段
+    std::cout << "第一条记录的字段:";
+    ForEachField(*step.View().begin(), [](int stepid, Span value)
+                 { std::cout << " " << stepid << "=" << value.ToString(); });
+    std::cout << std::endl;
 }
 
 void SpecialCharacterExample()
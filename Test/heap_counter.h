@@ -0,0 +1,81 @@
+/*
+ * @Description: 统计堆分配次数的全局 operator new/delete 替换
+ * @Author: yubo
+ * @Date: 2025-03-10
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * 替换全部形式的 operator new/delete(普通、数组、nothrow、带长度、对齐)，统一用 malloc/free，
+ * 标准库内部用 nothrow 申请的缓冲(如 std::stable_sort)也计入且不会与库自带的 delete 错配。
+ * 替换函数不能内联，每个测试程序只能有一个源文件包含本头文件
+ */
+static std::atomic<size_t> g_heapAllocations{0};
+
+static void *CountedAlloc(std::size_t size) noexcept
+{
+    ++g_heapAllocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *ptr = CountedAlloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return CountedAlloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return CountedAlloc(size); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+#ifdef __cpp_aligned_new
+static void *CountedAlignedAlloc(std::size_t size, std::align_val_t align) noexcept
+{
+    ++g_heapAllocations;
+    // aligned_alloc要求长度是对齐的整数倍
+    std::size_t alignment = static_cast<std::size_t>(align);
+    std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+}
+
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    if (void *ptr = CountedAlignedAlloc(size, align))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return CountedAlignedAlloc(size, align);
+}
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return CountedAlignedAlloc(size, align);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { std::free(ptr); }
+#endif
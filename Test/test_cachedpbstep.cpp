@@ -0,0 +1,125 @@
+#include "../PBStep/CachedPBStep.h"
+#include "stepdef.h"
+#include <iostream>
+#include <cassert>
+
+// 取出缓存池，用于检查结点个数
+class InspectablePBStep : public CachedPBStep
+{
+public:
+    using CachedPBStep::getCachePool;
+};
+
+// 升档测试：超过当前档位的记录追加新档位结点，已有记录原地保留
+void TestTierEscalation()
+{
+    std::cout << "Testing tier escalation..." << std::endl;
+
+    InspectablePBStep step;
+    step.Init();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        step.EndAppendRecord();
+    }
+
+    step.GotoFirst();
+    std::string firstBefore = step.GetStepValueByID(STEP_HYDM);
+
+    // 超过第一档(4K)的记录
+    std::string large(10 * 1024, 'x');
+    step.AppendRecord();
+    step.AddFieldValue(STEP_XXNR, large);
+    step.EndAppendRecord();
+    // 每次升档只新增一个新档位的结点
+    assert(step.getCachePool().Capacity() == 2);
+
+    // 超过第二档(16K)的记录
+    std::string larger(40 * 1024, 'y');
+    step.AppendRecord();
+    step.AddFieldValue(STEP_XXNR, larger);
+    step.EndAppendRecord();
+    assert(step.getCachePool().Capacity() == 3);
+
+    assert(step.RecordsCount() == 12);
+
+    step.GotoFirst();
+    assert(step.GetStepValueByID(STEP_HYDM) == firstBefore);
+    for (int i = 1; i < 10; ++i)
+    {
+        step.GotoNext();
+        assert(step.GetStepValueByID(STEP_HYDM) == std::to_string(600000 + i));
+    }
+    step.GotoNext();
+    assert(step.GetStepValueByID(STEP_XXNR) == large);
+    step.GotoNext();
+    assert(step.GetStepValueByID(STEP_XXNR) == larger);
+
+    // 重置后混合档位的结点继续复用
+    std::string serialized = step.ToString();
+    step.Init();
+    bool result = step.SetPackage(serialized);
+    assert(result);
+    assert(step.RecordsCount() == 12);
+    assert(step.ToString() == serialized);
+    assert(step.getCachePool().Capacity() == 3);
+
+    std::cout << "Tier escalation test passed!" << std::endl;
+}
+
+// 容量提示：缓存池一次预留到位，添加记录不再新增结点
+void TestExpectRecords()
+{
+    std::cout << "Testing capacity hints..." << std::endl;
+
+    InspectablePBStep step;
+    step.Init();
+    step.ExpectRecords(1000, 40);
+
+    // 总容量不少于1000 * 40字节，第一档每个结点4K
+    const int nodes = step.getCachePool().Capacity();
+    assert(nodes == (1000 * 40 + CachedPBStep::CacheBlockSizeTier1 - 1) / CachedPBStep::CacheBlockSizeTier1);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        step.AddFieldValue(STEP_SCDM, "SH");
+        step.EndAppendRecord();
+    }
+    assert(step.getCachePool().Capacity() == nodes);
+    assert(step.RecordsCount() == 1000);
+
+    std::string serialized = step.ToString();
+    CachedPBStep parsed;
+    bool result = parsed.SetPackage(serialized);
+    assert(result);
+    assert(parsed.ToString() == serialized);
+
+    // 平均长度超过第三档时按第三档预留：第一个4K结点 + 4个64K结点
+    InspectablePBStep large;
+    large.Init();
+    large.ExpectRecords(4, 1 << 20);
+    assert(large.getCachePool().Capacity() == 5);
+
+    std::cout << "Capacity hints test passed!" << std::endl;
+}
+
+int main()
+{
+    try
+    {
+        TestTierEscalation();
+        TestExpectRecords();
+
+        std::cout << "\nAll tests passed successfully!" << std::endl;
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -186,6 +186,61 @@ void TestMemoryUsage()
     std::cout << "  Records per second: " << (recordCount * 1000.0 / duration.count()) << std::endl;
 }
 
+// 大页内存池对比测试：超大结果集的ToString及顺序遍历
+void TestPoolBackends()
+{
+    std::cout << "\nTesting pool backends with large package..." << std::endl;
+
+    const int recordCount = 100000;
+    auto testData = GenerateTestData(recordCount);
+
+    const PoolBackend backends[] = {PoolBackend::Heap, PoolBackend::HugePage};
+    for (PoolBackend backend : backends)
+    {
+        CachedGatePBStep step(backend);
+        step.Init();
+        step.SetBaseFieldValueInt(STEP_FUNC, 1001);
+
+        for (const auto &record : testData)
+        {
+            step.AppendRecord();
+            step.AddFieldValue(STEP_SCDM, record.scdm);
+            step.AddFieldValue(STEP_HYDM, record.hydm);
+            step.AddFieldValue(STEP_HYCS, record.hycs);
+            step.AddFieldValue(STEP_WTSX, record.wtsx);
+            step.AddFieldValue(STEP_DWBZJ, record.dwbzj);
+            step.AddFieldValue(STEP_BDDM, record.bddm);
+            step.AddFieldValue(STEP_BDMC, record.bdmc);
+            step.AddFieldValue(STEP_XQJG, record.xqjg);
+            step.EndAppendRecord();
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::string serialized = step.ToString();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto serializeUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        size_t checksum = 0;
+        step.GotoFirst();
+        for (int i = 0; i < step.RecordsCount(); ++i)
+        {
+            checksum += step.GetStepValueByID(STEP_HYDM).size();
+            checksum += step.GetStepValueByID(STEP_XQJG).size();
+            step.GotoNext();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto traverseUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+        assert(step.RecordsCount() == recordCount);
+        assert(checksum > 0);
+
+        std::cout << (backend == PoolBackend::Heap ? "Heap backend:" : "HugePage backend:") << std::endl;
+        std::cout << "  ToString: " << serializeUs << " microseconds (" << serialized.size() << " bytes)" << std::endl;
+        std::cout << "  Traverse: " << traverseUs << " microseconds" << std::endl;
+    }
+}
+
 int main()
 {
     try
@@ -211,6 +266,9 @@ int main()
         
         // 内存使用测试
         TestMemoryUsage();
+
+        // 内存池后端对比
+        TestPoolBackends();
         
         std::cout << "\nAll tests completed successfully!" << std::endl;
         return 0;
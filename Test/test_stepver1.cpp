@@ -0,0 +1,461 @@
+/*
+ * @Description: StepVer1 各存储策略及内存块工具的功能测试
+ * @Author: yubo
+ * @Date: 2025-03-03
+ */
+
+#include "../StepVer1/MultiRecordStream.h"
+#include "../StepVer1/MultiRecordStreamWithPool.h"
+#include "../StepVer1/MultiRecordStreamWithMem.h"
+#include "../StepVer1/MultiRecordStreamWithArena.h"
+#include "../StepVer1/SingleRecordStream.h"
+#include "../Tool/MemBlockList.h"
+#include "stepdef.h"
+// 统计堆分配次数，用于验证容量提示后添加记录不再扩容
+#include "heap_counter.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace step;
+
+// 每条记录长度相同："63=6xxxxx&54=SH&244=1xx&"，共24字节
+const size_t s_RecordBytes = 24;
+
+template <class Stream>
+void FillRecords(Stream &stream, int recordCount)
+{
+    for (int i = 0; i < recordCount; ++i)
+    {
+        stream.AppendRecord();
+        stream.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        stream.AddFieldValue(STEP_SCDM, "SH");
+        stream.AddFieldValue(STEP_HYCS, 100 + i % 900);
+        stream.EndAppendRecord();
+    }
+}
+
+// 给出容量提示后添加记录的堆分配次数
+template <class Stream>
+size_t AllocationsAfterHint(Stream &stream, int recordCount)
+{
+    stream.Init();
+    stream.SetBaseFieldValueString(STEP_FUNC, "1001");
+    stream.ExpectRecords(recordCount, s_RecordBytes);
+
+    size_t before = g_heapAllocations;
+    FillRecords(stream, recordCount);
+    size_t allocations = g_heapAllocations - before;
+
+    assert(stream.RecordsCount() == static_cast<size_t>(recordCount));
+    assert(stream.GetFieldValue(recordCount - 1, STEP_HYDM) == std::to_string(600000 + recordCount - 1));
+    return allocations;
+}
+
+void TestExpectRecords()
+{
+    std::cout << "Testing capacity hints..." << std::endl;
+
+    const int recordCount = 1000;
+
+    // vector<map>：记录索引一次预留到位，每条记录的map节点仍需分配
+    MultiRecordStream byMap;
+    byMap.Init();
+    byMap.ExpectRecords(recordCount, s_RecordBytes);
+    const auto *records = byMap.GetStorage().Records().data();
+    assert(byMap.GetStorage().Records().capacity() >= static_cast<size_t>(recordCount));
+    FillRecords(byMap, recordCount);
+    assert(byMap.GetStorage().Records().data() == records);
+
+    // arena和内存块：添加记录不再分配
+    MultiRecordStreamWithArena byArena;
+    assert(AllocationsAfterHint(byArena, recordCount) == 0);
+    MultiRecordStreamWithMem byMem;
+    assert(AllocationsAfterHint(byMem, recordCount) == 0);
+
+    // slab池：对应档位在首次分配时一次申请所有块，记录都落在同一段连续内存中
+    MultiRecordStreamWithPool byPool;
+    AllocationsAfterHint(byPool, recordCount);
+    const SlabPoolStorage &slabs = byPool.GetStorage();
+    const int slabClass = SlabPoolStorage::SlabClassOf(s_RecordBytes);
+    const char *lowest = slabs.Record(0).first;
+    const char *highest = lowest;
+    for (size_t i = 0; i < slabs.Count(); ++i)
+    {
+        assert(slabs.SlabClass(i) == slabClass);
+        lowest = std::min(lowest, slabs.Record(i).first);
+        highest = std::max(highest, slabs.Record(i).first);
+    }
+    assert(static_cast<size_t>(highest - lowest) < recordCount * (static_cast<size_t>(s_MinSlabSize) << slabClass));
+
+    // 输出缓存按提示一次预留
+    std::string expected = byArena.ToSerialized();
+    assert(expected.size() == ::strlen("3=1001&\n") + recordCount * (s_RecordBytes + 1));
+    size_t before = g_heapAllocations;
+    std::string serialized = byMem.ToSerialized();
+    assert(g_heapAllocations - before == 1);
+    assert(serialized == expected);
+    assert(byPool.ToSerialized() == expected);
+    // map按stepid顺序输出字段，长度相同
+    assert(byMap.ToSerialized().size() == expected.size() - ::strlen("3=1001&"));
+
+    std::cout << "Capacity hints test passed!" << std::endl;
+}
+
+void TestSlabClasses()
+{
+    std::cout << "Testing slab classes..." << std::endl;
+
+    // 档位边界：64、128、...、8K，恰好等于档位长度的记录不升档
+    assert(SlabPoolStorage::SlabClassOf(1) == 0);
+    for (int i = 0; i < s_SlabClassCount; ++i)
+    {
+        size_t slabSize = static_cast<size_t>(s_MinSlabSize) << i;
+        assert(SlabPoolStorage::SlabClassOf(slabSize) == i);
+        assert(SlabPoolStorage::SlabClassOf(slabSize + 1) == i + 1);
+    }
+    assert((s_MinSlabSize << (s_SlabClassCount - 1)) == s_MaxItemSize);
+
+    // 按记录长度选择档位，超过8K的记录向系统申请；记录为 "190=xxx&"，比值长5字节
+    MultiRecordStreamWithPool stream;
+    stream.Init();
+    const size_t lengths[] = {6, 64, 65, 128, 129, 4096, 8192, 8193, 20000};
+    const int classes[] = {0, 0, 1, 1, 2, 6, 7, -1, -1};
+    size_t total = 0;
+    for (size_t len : lengths)
+    {
+        stream.AppendRecord();
+        stream.AddFieldValue(STEP_XXNR, std::string(len - 5, 'x'));
+        stream.EndAppendRecord();
+        total += len;
+    }
+
+    const SlabPoolStorage &storage = stream.GetStorage();
+    assert(storage.Count() == sizeof(lengths) / sizeof(lengths[0]));
+    assert(storage.DataSize() == total);
+    for (size_t i = 0; i < storage.Count(); ++i)
+    {
+        assert(storage.SlabClass(i) == classes[i]);
+        assert(storage.Record(i).second == lengths[i]);
+    }
+    assert(stream.GetFieldValue(8, STEP_XXNR).size() == 20000 - 5);
+
+    // 记录按精确长度序列化：复用的slab中残留更长的旧数据，值中含'\0'
+    stream.Init();
+    stream.AppendRecord();
+    stream.AddFieldValue(STEP_XXNR, std::string(115, 'y'));
+    stream.EndAppendRecord();
+    stream.Init();
+
+    std::string value("ab", 2);
+    value.push_back('\0');
+    value.append(62, 'z');
+    stream.AppendRecord();
+    stream.AddFieldValue(STEP_XXNR, value);
+    stream.EndAppendRecord();
+    assert(stream.GetStorage().SlabClass(0) == 1);
+
+    std::string expected = fmt::format("\n{}={}&\n", STEP_XXNR, value);
+    assert(stream.ToSerialized() == expected);
+
+    // 反序列化的记录同样按精确长度存储
+    MultiRecordStreamWithPool parsed;
+    bool result = parsed.DoDeserialize(expected);
+    assert(result);
+    assert(parsed.GetFieldValue(0, STEP_XXNR) == value);
+    assert(parsed.ToSerialized() == expected);
+
+    std::cout << "Slab classes test passed!" << std::endl;
+}
+
+std::string ToString(std::pair<const char *, size_t> view)
+{
+    return view.first == nullptr ? std::string() : std::string(view.first, view.second);
+}
+
+void TestMemBlock()
+{
+    std::cout << "Testing memory blocks..." << std::endl;
+
+    // 每条数据记录自身长度，含'\0'和空数据；删除后其他数据的长度不变
+    MemBlock block(64);
+    const std::string items[] = {"abc", "", std::string("de\0f", 4), "ghij"};
+    int index = -1;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        bool result = block.PushBack(items[i].data(), items[i].size(), index);
+        assert(result && index == static_cast<int>(i));
+    }
+    assert(block.LeftSize() == 64 - 11);
+    for (int i = 0; i < 4; ++i)
+    {
+        assert(ToString(block.Get(i)) == items[i]);
+    }
+
+    block.Delete(2);
+    assert(block.Get(2).first == nullptr && block.Get(2).second == 0);
+    assert(ToString(block.Get(1)) == "" && block.Get(1).first != nullptr);
+    assert(ToString(block.Get(3)) == "ghij");
+    // 剩余空间不足时拒绝，不改变内存块
+    bool result = block.PushBack(std::string(60, 'q').data(), 60, index);
+    assert(!result && index == 3);
+    assert(block.LeftSize() == 64 - 11);
+
+    // 重置不清零内存：旧数据仍在，新数据按自身长度读取
+    const char *first = block.Get(0).first;
+    block.Reset();
+    assert(block.LeftSize() == 64);
+    result = block.PushBack("xy", 2, index);
+    assert(result && index == 0);
+    assert(block.Get(0).first == first && ToString(block.Get(0)) == "xy");
+    assert(::memcmp(first + 2, "c", 1) == 0);
+
+    // 列表：按块存放，遍历直接给出视图，删除的数据跳过
+    MemBlockList list(16);
+    const std::string records[] = {"0123456789", "abcdef", "ABCDEFGHIJ", "xyz", "!"};
+    size_t total = 0;
+    for (const auto &record : records)
+    {
+        list.PushData(record.data(), record.size());
+        total += record.size();
+    }
+    assert(list.Count() == 5 && list.DataSize() == total);
+
+    size_t visited = 0;
+    list.Traverse([&](const char *data, size_t len)
+                  {
+                      assert(data == list.Get(visited).first);
+                      assert(std::string(data, len) == records[visited]);
+                      ++visited;
+                  });
+    assert(visited == 5);
+
+    list.Delete(2);
+    list.Delete(2);
+    assert(list.Count() == 5 && list.DataSize() == total - 10);
+    assert(list.Get(2).first == nullptr);
+    std::vector<std::string> copied = list.Traverse();
+    assert(copied.size() == 4 && copied[1] == "abcdef" && copied[2] == "xyz");
+    size_t bytes = 0;
+    list.Traverse([&bytes](const char *, size_t len)
+                  { bytes += len; });
+    assert(bytes == list.DataSize());
+
+    // 重置后复用原有内存块
+    const char *head = list.Get(0).first;
+    list.Reset();
+    assert(list.Count() == 0 && list.DataSize() == 0);
+    list.PushData("hello", 5);
+    assert(list.Get(0).first == head && ToString(list.Get(0)) == "hello");
+
+    // 超过块容量的数据单独占用一块，第一条数据也可以；之后的数据接着存放
+    const std::string oversize(40, 'L');
+    MemBlockList wide(16);
+    wide.PushData(oversize.data(), oversize.size());
+    wide.PushData("x", 1);
+    wide.PushData("0123456789abcdef", 16);
+    wide.PushData(oversize.data(), oversize.size());
+    assert(wide.Count() == 4 && wide.DataSize() == 97);
+    assert(ToString(wide.Get(0)) == oversize && ToString(wide.Get(1)) == "x");
+    assert(ToString(wide.Get(2)) == "0123456789abcdef" && ToString(wide.Get(3)) == oversize);
+
+    // 反序列化超过默认块大小(4K)的记录
+    MultiRecordStreamWithArena source;
+    source.Init();
+    source.SetBaseFieldValueString(STEP_FUNC, "1001");
+    const size_t lengths[] = {5000, 10, 10000, 3};
+    for (size_t len : lengths)
+    {
+        source.AppendRecord();
+        source.AddFieldValue(STEP_XXNR, std::string(len, 'v'));
+        source.EndAppendRecord();
+    }
+    const std::string serialized = source.ToSerialized();
+
+    MultiRecordStreamWithMem parsed;
+    result = parsed.DoDeserialize(serialized);
+    assert(result);
+    assert(parsed.RecordsCount() == 4);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        assert(parsed.GetFieldValue(i, STEP_XXNR) == std::string(lengths[i], 'v'));
+    }
+    assert(parsed.ToSerialized() == serialized);
+
+    std::cout << "Memory blocks test passed!" << std::endl;
+}
+
+// 反序列化后一次建好字段索引，读取不修改对象，可多线程并发
+template <class Stream>
+void CheckConcurrentReads(const std::string &serialized, int recordCount)
+{
+    Stream stream;
+    bool result = stream.DoDeserialize(serialized);
+    assert(result);
+
+    size_t before = g_heapAllocations;
+    size_t found = 0;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        found += (stream.GetFieldRaw(i, STEP_SCDM).first != nullptr);
+    }
+    assert(found == static_cast<size_t>(recordCount));
+    assert(g_heapAllocations - before == 0);
+
+    const Stream &shared = stream;
+    std::vector<size_t> checksums(4, 0);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < checksums.size(); ++t)
+    {
+        readers.emplace_back([&shared, &checksums, t, recordCount]()
+                             {
+                                 for (int i = recordCount - 1; i >= 0; --i)
+                                 {
+                                     checksums[t] += shared.GetFieldRaw(i, STEP_HYDM).second;
+                                 }
+                             });
+    }
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+    for (size_t checksum : checksums)
+    {
+        assert(checksum == static_cast<size_t>(recordCount) * 6);
+    }
+}
+
+void TestConcurrentReads()
+{
+    std::cout << "Testing concurrent reads..." << std::endl;
+
+    const int recordCount = 10000;
+    MultiRecordStreamWithArena source;
+    source.Init();
+    FillRecords(source, recordCount);
+    const std::string serialized = source.ToSerialized();
+
+    CheckConcurrentReads<MultiRecordStream>(serialized, recordCount);
+    CheckConcurrentReads<MultiRecordStreamWithPool>(serialized, recordCount);
+    CheckConcurrentReads<MultiRecordStreamWithMem>(serialized, recordCount);
+    CheckConcurrentReads<MultiRecordStreamWithArena>(serialized, recordCount);
+
+    std::cout << "Concurrent reads test passed!" << std::endl;
+}
+
+void TestSingleRecordInline()
+{
+    std::cout << "Testing inline single record..." << std::endl;
+
+    // 小包整体拷贝到对象内部，解包不申请堆内存
+    const std::string small = "3=1001&2=a\\bb&\n63=600000&54=SH&190=x\\ay\\\\z&\n";
+    SingleRecordStream request;
+    size_t before = g_heapAllocations;
+    bool result = request.DoDeserialize(small);
+    assert(result);
+    assert(g_heapAllocations - before == 0);
+    assert(request.IsInline());
+
+    // 读取时反转义，已有的值不被后添加的同名字段覆盖
+    assert(request.GetBaseFieldValue(STEP_FUNC) == "1001");
+    assert(request.GetBaseFieldValue(STEP_MSG) == "a&b");
+    assert(request.GetFieldValue(STEP_HYDM) == "600000");
+    assert(request.GetFieldValue(STEP_XXNR) == "x=y\\z");
+    assert(request.GetFieldValue(STEP_HYCS).empty());
+    request.AddFieldValue(STEP_SCDM, "SZ");
+    assert(!request.IsInline());
+    assert(request.GetFieldValue(STEP_SCDM) == "SH");
+    assert(request.GetFieldValue(STEP_XXNR) == "x=y\\z");
+
+    // 序列化结果与按map解包的结果相同
+    SingleRecordStream plain;
+    result = plain.DoDeserialize("3=1001&\n63=600000&54=SH&\n");
+    assert(result && plain.IsInline());
+    assert(plain.ToSerialized() == "3=1001&\n54=SH&63=600000&\n");
+
+    // 包过大时退回到map存储
+    const std::string text(STEP_SINGLE_RECORD_INLINE_SIZE, 'x');
+    const std::string large = "3=1002&\n63=600001&190=" + text + "&\n";
+    result = request.DoDeserialize(large);
+    assert(result);
+    assert(!request.IsInline());
+    assert(request.GetBaseFieldValue(STEP_FUNC) == "1001"); // 包头字段与原实现一致，不清除旧值
+    assert(request.GetFieldValue(STEP_HYDM) == "600001");
+    assert(request.GetFieldValue(STEP_XXNR) == text);
+
+    // 字段数超过内联索引容量时同样退回
+    std::string many = "3=1003&\n";
+    for (int i = 0; i <= STEP_SINGLE_RECORD_INLINE_FIELDS; ++i)
+    {
+        many.append(fmt::format("{}={}&", 1000 + i, i));
+    }
+    SingleRecordStream wide;
+    result = wide.DoDeserialize(many);
+    assert(result);
+    assert(!wide.IsInline());
+    assert(wide.GetBaseFieldValue(STEP_FUNC) == "1003");
+    assert(wide.GetFieldValue(1000) == "0");
+    assert(wide.GetFieldValue(1000 + STEP_SINGLE_RECORD_INLINE_FIELDS) == std::to_string(STEP_SINGLE_RECORD_INLINE_FIELDS));
+
+    // 再次解包小包时重新使用内联缓存
+    result = wide.DoDeserialize(small);
+    assert(result && wide.IsInline());
+    assert(wide.GetFieldValue(1000).empty());
+    assert(wide.GetFieldValue(STEP_HYDM) == "600000");
+
+    std::cout << "Inline single record test passed!" << std::endl;
+}
+
+void TestSingleRecordRoundTrip()
+{
+    std::cout << "Testing single record round trip..." << std::endl;
+
+    // 包头和包体的值都按原值存储，序列化时转义，解包后还原
+    SingleRecordStream response;
+    response.Init();
+    response.SetBaseFieldValueString(STEP_FUNC, "1001");
+    response.SetBaseFieldValueString(STEP_MSG, "a=1&b\\n");
+    assert(response.GetBaseFieldValue(STEP_MSG) == "a=1&b\\n");
+    response.AddFieldValue(STEP_HYDM, "600000");
+    response.AddFieldValue(STEP_XXNR, "line1\nline2&x=y");
+    response.AddFieldValue(STEP_HYCS, 100);
+
+    const std::string serialized = response.ToSerialized();
+    assert(serialized == "2=a\\a1\\bb\\\\n&3=1001&\n63=600000&190=line1\\nline2\\bx\\ay&244=100&\n");
+
+    SingleRecordStream parsed;
+    bool result = parsed.DoDeserialize(serialized);
+    assert(result);
+    assert(parsed.GetBaseFieldValue(STEP_MSG) == "a=1&b\\n");
+    assert(parsed.GetFieldValue(STEP_XXNR) == "line1\nline2&x=y");
+    assert(parsed.GetFieldValue(STEP_HYCS) == "100");
+    assert(parsed.ToSerialized() == serialized);
+
+    std::cout << "Single record round trip test passed!" << std::endl;
+}
+
+int main()
+{
+    try
+    {
+        TestExpectRecords();
+        TestSlabClasses();
+        TestMemBlock();
+        TestConcurrentReads();
+        TestSingleRecordInline();
+        TestSingleRecordRoundTrip();
+
+        std::cout << "\nAll tests passed successfully!" << std::endl;
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
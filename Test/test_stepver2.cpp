@@ -1,8 +1,25 @@
 #include "../StepVer2/StepVer2.h"
+#include "../StepVer2/RouteParser.h"
+#include "../StepVer2/PackageView.h"
+#include "../StepVer2/RecordFilter.h"
+#include "../StepVer2/SortedMerge.h"
+#include "../StepVer2/PackageFrames.h"
+#include "../StepVer2/ColumnSet.h"
+#include "../StepVer2/Aggregate.h"
+#include "../StepVer2/LzCodec.h"
 #include "stepdef.h"
+// 统计堆分配次数，用于验证小包解包不申请堆内存
+#include "heap_counter.h"
 #include <iostream>
 #include <cassert>
 #include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace stepver2;
 
@@ -195,6 +212,1640 @@ void TestPerformance()
     std::cout << "Performance test completed!" << std::endl;
 }
 
+// 启动预热测试
+void TestWarmUp()
+{
+    std::cout << "Testing warm-up..." << std::endl;
+
+    WarmUpProfile profile;
+    profile.objects = 2;
+    profile.records = 2000;
+    profile.avgRecordBytes = 100;
+
+    CachedGatePBStep steps[3];
+    WarmUpReport report = warmup::WarmUpObjects(std::begin(steps), std::end(steps), profile);
+    assert(report.objects == 2);
+    assert(report.reservedBytes >= 2 * profile.records * profile.avgRecordBytes);
+    assert(report.elapsedUs >= 0);
+
+    // 预热后正常使用
+    CachedGatePBStep &step = steps[0];
+    step.AppendRecord();
+    step.AddFieldValue(STEP_SCDM, "SH");
+    step.EndAppendRecord();
+    step.GotoFirst();
+    assert(step.GetStepValueByID(STEP_SCDM) == "SH");
+
+    std::cout << "Warm-up test passed! (" << report.elapsedUs << " us, "
+              << report.reservedBytes << " bytes)" << std::endl;
+}
+
+// 按功能号学习容量测试
+void TestCapacityLearning()
+{
+    std::cout << "Testing per-function capacity learning..." << std::endl;
+
+    CapacityLearner learner;
+    CachedGatePBStep step;
+    step.SetCapacityLearner(&learner);
+
+    // 大查询
+    step.BeginResponse(5001);
+    for (int i = 0; i < 500; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        step.AddFieldValue(STEP_HYCS, i);
+        step.EndAppendRecord();
+    }
+    std::string large = step.ToString();
+
+    // 小查询
+    step.BeginResponse(5002);
+    step.AppendRecord();
+    step.AddFieldValue(STEP_DWBZJ, 1.5);
+    step.EndAppendRecord();
+    std::string small = step.ToString();
+
+    CapacityLearner::Estimate largeEstimate = learner.Predict(5001);
+    CapacityLearner::Estimate smallEstimate = learner.Predict(5002);
+    assert(largeEstimate.records == 500);
+    assert(largeEstimate.bytes < large.size() && largeEstimate.bytes + 32 > large.size());
+    assert(smallEstimate.records == 1);
+    assert(learner.Predict(5003).records == 0);
+
+    // 跟踪的功能号已满时只继续学习已有的功能号
+    CapacityLearner bounded(0.9, 2);
+    bounded.Observe(1, 10, 100);
+    bounded.Observe(2, 20, 200);
+    bounded.Observe(3, 30, 300);
+    assert(bounded.Predict(3).records == 0);
+    bounded.Observe(1, 11, 110);
+    assert(bounded.Predict(1).records == 11 && bounded.Predict(2).records == 20);
+    bounded.Clear();
+    bounded.Observe(3, 30, 300);
+    assert(bounded.Predict(3).records == 30);
+
+    // 再次开始大查询，基础记录带上功能号且结果一致
+    step.BeginResponse(5001);
+    assert(step.GetBaseFieldValue(STEP_FUNC) == "5001");
+    assert(step.RecordsCount() == 0);
+
+    std::cout << "Capacity learning test passed!" << std::endl;
+}
+
+// 容量提示测试
+void TestExpectRecords()
+{
+    std::cout << "Testing capacity hints..." << std::endl;
+
+    CachedGatePBStep step;
+    step.Init();
+    step.ExpectRecords(1000, 40);
+
+    // 记录索引、内存池和临时缓存已一次预留，添加记录不再分配
+    size_t before = g_heapAllocations;
+    for (int i = 0; i < 1000; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        step.AddFieldValue(STEP_SCDM, "SH");
+        step.EndAppendRecord();
+    }
+    assert(g_heapAllocations - before == 0);
+
+    // 输出缓存按提示一次预留
+    before = g_heapAllocations;
+    std::string serialized = step.ToString();
+    assert(g_heapAllocations - before == 1);
+    assert(step.RecordsCount() == 1000);
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(serialized);
+    assert(result);
+    assert(parsed.RecordsCount() == 1000);
+    assert(parsed.ToString() == serialized);
+
+    std::cout << "Capacity hints test passed!" << std::endl;
+}
+
+void TestInlinePackage()
+{
+    std::cout << "Testing inline small packages..." << std::endl;
+
+    CachedGatePBStep request;
+    // 包头乱序且含转义字符，包体最后一个字段没有'&'
+    const std::string package = "3=1001&2=a\\bb&\n121=600000&122=x\\ay";
+
+    size_t before = g_heapAllocations;
+    bool ok = request.SetPackage(package);
+    size_t allocations = g_heapAllocations - before;
+    assert(ok);
+    assert(allocations == 0);
+
+    assert(request.RecordsCount() == 1);
+    assert(request.GetBaseFieldValue(STEP_FUNC) == "1001");
+    assert(request.GetBaseFieldValue(STEP_MSG) == "a&b");
+    assert(request.GetStepValueByID(STEP_BDDM) == "600000");
+    assert(request.GetStepValueByID(STEP_BDMC) == "x=y");
+    assert(request.GetStepValueByID(STEP_HYDM).empty());
+    assert(request.ToString() == "2=a\\bb&3=1001&\n121=600000&122=x\\ay&\n");
+
+    // 修改包头后转存到map，已有字段保持不变
+    request.SetBaseFieldValueInt(STEP_CODE, 0);
+    assert(request.GetBaseFieldValue(STEP_MSG) == "a&b");
+    assert(request.GetBaseFieldValue(STEP_CODE) == "0");
+
+    // 超过内联长度的包仍走内存池
+    CachedGatePBStep large;
+    large.Init();
+    large.SetBaseFieldValueInt(STEP_FUNC, 1001);
+    for (int i = 0; i < 100; ++i)
+    {
+        large.AppendRecord();
+        large.AddFieldValue(STEP_HYDM, std::to_string(600000 + i));
+        large.AddFieldValue(STEP_SCDM, "SH");
+        large.EndAppendRecord();
+    }
+    std::string serialized = large.ToString();
+    assert(serialized.size() > STEPVER2_INLINE_PACKAGE_SIZE);
+    bool result = request.SetPackage(serialized);
+    assert(result);
+    assert(request.RecordsCount() == 100);
+    assert(request.GetBaseFieldValue(STEP_FUNC) == "1001");
+    assert(request.ToString() == serialized);
+
+    std::cout << "Inline small package test passed!" << std::endl;
+}
+
+void TestRouteParser()
+{
+    std::cout << "Testing header-only route parser..." << std::endl;
+
+    RouteInfo route;
+    const std::string package = "2=a\\b\\n&3=1001&4=88&5=123456789012&\n3=9999&4=1&\n";
+
+    size_t before = g_heapAllocations;
+    bool ok = ParseRoute(package, route);
+    size_t allocations = g_heapAllocations - before;
+    assert(ok);
+    assert(allocations == 0);
+    assert(route.funcId == 1001);
+    assert(route.session == 88);
+    assert(route.requestNo == 123456789012LL);
+
+    // 只看第一行；含转义的值不是整数；重复的stepid取第一个
+    const int ids[] = {STEP_MSG, STEP_CODE, STEP_FUNC};
+    int64_t values[] = {-1, -1, -1};
+    uint64_t found = ParseHeadInts(package.data(), package.size(), ids, values, 3);
+    assert(found == 4);
+    assert(values[0] == -1 && values[1] == -1 && values[2] == 1001);
+
+    const std::string dup = "3=x&3=1002&\n";
+    ok = ParseRoute(dup, route);
+    assert(!ok);
+
+    ok = ParseRoute(std::string("\n3=1001&"), route);
+    assert(!ok);
+    ok = ParseRoute(std::string("3=-7"), route);
+    assert(ok && route.funcId == -7);
+
+    // 功能号超出int范围时视为无效，不截断
+    ok = ParseRoute(std::string("3=2147483647&"), route);
+    assert(ok && route.funcId == INT_MAX);
+    ok = ParseRoute(std::string("3=4294968297&4=88&"), route);
+    assert(!ok && route.funcId == 0 && route.session == 88);
+    ok = ParseRoute(std::string("3=-2147483649&"), route);
+    assert(!ok && route.funcId == 0);
+
+    // 与完整解析的结果一致
+    CachedGatePBStep step;
+    ok = step.SetPackage(package);
+    assert(ok);
+    assert(step.GetBaseFieldValue(STEP_FUNC) == "1001");
+
+    std::cout << "Route parser test passed!" << std::endl;
+}
+
+void TestPackageView()
+{
+    std::cout << "Testing read-only package views..." << std::endl;
+
+    CachedGatePBStep step;
+    step.Init();
+    step.SetBaseFieldValueInt(STEP_FUNC, 1001);
+    const int recordCount = 10000;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, i);
+        step.AddFieldValue(STEP_XXNR, "a=b", true);
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+    PackageView view = parsed.View();
+    assert(view.RecordsCount() == static_cast<size_t>(recordCount));
+    assert(view.GetBaseFieldValue(STEP_FUNC) == "1001");
+
+    // 多个线程各持一个游标，并发读取同一个包
+    const int threadCount = 4;
+    std::vector<long long> sums(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&view, &sums, t]()
+                             {
+                                 RecordCursor cursor = view.Cursor();
+                                 for (cursor.GotoFirst(); cursor.Valid(); cursor.GotoNext())
+                                 {
+                                     sums[t] += std::stoll(cursor.GetRaw(STEP_HYDM).ToString());
+                                     if (cursor.GetStepValueByID(STEP_XXNR) != "a=b")
+                                     {
+                                         sums[t] = -1;
+                                         return;
+                                     }
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    const long long expected = 1LL * recordCount * (recordCount - 1) / 2;
+    for (long long sum : sums)
+    {
+        assert(sum == expected);
+    }
+
+    // 游标不影响对象自身的当前记录
+    RecordCursor cursor = view.Cursor();
+    cursor.Seek(42);
+    assert(cursor.GetRaw(STEP_HYDM) == "42");
+    assert(cursor.GetRaw(STEP_HYDMMC).data == nullptr);
+    assert(parsed.GetStepValueByID(STEP_HYDM) == "0");
+
+    // 由临时视图得到的游标和迭代器不引用已销毁的视图
+    RecordCursor temporary(parsed.View());
+    temporary.Seek(7);
+    assert(temporary.GetRaw(STEP_HYDM) == "7");
+    RecordIterator first = parsed.View().begin();
+    ++first;
+    assert((*first).GetRaw(STEP_HYDM) == "1");
+    assert(first != parsed.View().end());
+
+    // 修改后的记录长度与内容一致
+    result = parsed.SetFieldValue(STEP_HYDM, "x");
+    assert(result);
+    assert(parsed.FormatedRecords(0, 1) == "63=x&190=a\\ab&\n");
+    assert((*view.begin()).GetRaw(STEP_HYDM) == "x");
+
+    std::cout << "Package view test passed!" << std::endl;
+}
+
+void TestRecordIteration()
+{
+    std::cout << "Testing range-based record iteration..." << std::endl;
+
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < 3; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, "SH");
+        step.AddFieldValue(STEP_HYDM, i);
+        step.AddFieldValue(STEP_XXNR, "a&b", true);
+        step.EndAppendRecord();
+    }
+
+    size_t expectedIndex = 0;
+    for (RecordRef record : step.View())
+    {
+        assert(record.Index() == expectedIndex);
+        assert(record.GetRaw(STEP_HYDM) == std::to_string(expectedIndex).c_str());
+        assert(record.GetStepValueByID(STEP_XXNR) == "a&b");
+        assert(record.GetRaw(STEP_HYCS).data == nullptr);
+        ++expectedIndex;
+    }
+    assert(expectedIndex == 3);
+
+    // 不知道字段id时按顺序列出所有字段，且不申请内存
+    PackageView view = step.View();
+    RecordRef first = *view.begin();
+    int ids[8] = {};
+    size_t fieldCount = 0;
+    size_t valueBytes = 0;
+    size_t before = g_heapAllocations;
+    ForEachField(first, [&](int stepid, Span value)
+                 {
+                     ids[fieldCount++] = stepid;
+                     valueBytes += value.size;
+                 });
+    size_t allocations = g_heapAllocations - before;
+    assert(allocations == 0);
+    assert(fieldCount == 3);
+    assert(ids[0] == STEP_SCDM && ids[1] == STEP_HYDM && ids[2] == STEP_XXNR);
+    assert(valueBytes == 2 + 1 + 4);
+
+    std::cout << "Record iteration test passed!" << std::endl;
+}
+
+void TestGetFields()
+{
+    std::cout << "Testing batched field lookup..." << std::endl;
+
+    const int recordCount = 10000;
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, (i % 2 == 0) ? "SH" : "SZ");
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        step.AddFieldValue(STEP_HYDMMC, "name&x", true);
+        step.AddFieldValue(STEP_HYCS, 100);
+        step.AddFieldValue(STEP_WTSX, i * 10);
+        step.AddFieldValue(STEP_ZCSX, i * 20);
+        step.AddFieldValue(STEP_XQJG, 10.5);
+        step.AddFieldValue(STEP_DWBZJ, 1000.25);
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+
+    const int ids[] = {STEP_SCDM, STEP_HYDM, STEP_HYDMMC, STEP_HYCS, STEP_WTSX, STEP_ZCSX, STEP_XQJG, STEP_DWBZJ, STEP_BDDM};
+    const size_t n = sizeof(ids) / sizeof(ids[0]);
+    Span values[n];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t batchFound = 0;
+    parsed.GotoFirst();
+    for (int i = 0; i < recordCount; ++i, parsed.GotoNext())
+    {
+        size_t fieldCount = parsed.GetFields(ids, n, values);
+        assert(fieldCount == n - 1);
+        for (const Span &value : values)
+        {
+            batchFound += (value.data != nullptr);
+        }
+    }
+    auto batchUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::high_resolution_clock::now() - start)
+                       .count();
+
+    start = std::chrono::high_resolution_clock::now();
+    size_t singleFound = 0;
+    parsed.GotoFirst();
+    for (int i = 0; i < recordCount; ++i, parsed.GotoNext())
+    {
+        for (int id : ids)
+        {
+            singleFound += !parsed.GetStepValueByID(id).empty();
+        }
+    }
+    auto singleUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+    assert(batchFound == singleFound);
+
+    // 结果与逐个查找一致，且不会越过当前记录
+    parsed.GotoFirst();
+    parsed.GotoNext();
+    parsed.GetFields(ids, n, values);
+    assert(values[0] == "SZ");
+    assert(values[1] == "600001");
+    assert(values[2] == "name\\bx");
+    assert(values[8].data == nullptr);
+
+    CachedGatePBStep adjacent;
+    result = adjacent.SetPackage("3=1&\n54=SH&\n63=600000&\n");
+    assert(result);
+    adjacent.GotoFirst();
+    assert(adjacent.GetStepValueByID(STEP_HYDM).empty());
+
+    RecordRef last = *std::next(parsed.View().begin(), recordCount - 1);
+    last.GetFields(ids, n, values);
+    assert(values[1] == std::to_string(600000 + recordCount - 1).c_str());
+
+    std::cout << "Batched lookup: " << batchUs << " us, per-field lookup: " << singleUs << " us" << std::endl;
+    std::cout << "Batched field lookup test passed!" << std::endl;
+}
+
+void TestFieldPatches()
+{
+    std::cout << "Testing overlay field patches..." << std::endl;
+
+    const int recordCount = 10000;
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, "SH");
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        step.AddFieldValue(STEP_WTSX, 100);
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+
+    // 每条记录改2个已有字段、加1个新字段，内存池只增加新值的长度
+    size_t usedBefore = parsed.PoolUsedSize();
+    parsed.GotoFirst();
+    for (int i = 0; i < recordCount; ++i, parsed.GotoNext())
+    {
+        result = parsed.SetFieldValue(STEP_SCDM, "SZ");
+        assert(result);
+        result = parsed.SetFieldValueInt(STEP_WTSX, i);
+        assert(result);
+        result = parsed.SetFieldValue(STEP_BDDM, "N");
+        assert(result);
+    }
+    assert(parsed.PoolUsedSize() - usedBefore < recordCount * 16);
+    assert(parsed.DeadBytes() == 0);
+
+    parsed.GotoFirst();
+    parsed.GotoNext();
+    assert(parsed.GetStepValueByID(STEP_SCDM) == "SZ");
+    assert(parsed.GetStepValueByID(STEP_WTSX) == "1");
+    assert(parsed.GetStepValueByID(STEP_BDDM) == "N");
+    assert(parsed.GetStepValueByID(STEP_HYDM) == "600001");
+    assert(parsed.FormatedRecords(1, 2) == "54=SZ&63=600001&246=1&121=N&\n");
+
+    // 视图和字段遍历看到的是修改后的内容
+    RecordRef second = *std::next(parsed.View().begin());
+    int ids[4] = {};
+    size_t fieldCount = 0;
+    ForEachField(second, [&](int stepid, Span) { ids[fieldCount++] = stepid; });
+    assert(fieldCount == 4 && ids[3] == STEP_BDDM);
+    assert(second.GetRaw(STEP_WTSX) == "1");
+
+    std::string patched = parsed.ToString();
+    CachedGatePBStep reparsed;
+    result = reparsed.SetPackage(patched);
+    assert(result);
+    assert(reparsed.ToString() == patched);
+
+    // 同一字段反复修改，废弃数据超过阈值后自动压缩
+    parsed.GotoFirst();
+    const std::string longValue(200, 'x');
+    for (int i = 0; i < 2000; ++i)
+    {
+        result = parsed.SetFieldValue(STEP_XXNR, longValue.c_str());
+        assert(result);
+    }
+    assert(parsed.DeadBytes() < 2000 * longValue.size());
+    assert(parsed.GetStepValueByID(STEP_XXNR) == longValue);
+
+    parsed.Compact();
+    assert(parsed.DeadBytes() == 0);
+    assert(parsed.GetStepValueByID(STEP_XXNR) == longValue);
+    assert(parsed.FormatedRecords(1, 2) == "54=SZ&63=600001&246=1&121=N&\n");
+    assert(parsed.RecordsCount() == recordCount);
+
+    std::cout << "Overlay field patches test passed!" << std::endl;
+}
+
+void TestValueIndex()
+{
+    std::cout << "Testing secondary value index..." << std::endl;
+
+    const int recordCount = 50000;
+    CachedGatePBStep dict;
+    dict.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        dict.AppendRecord();
+        dict.AddFieldValue(STEP_SCDM, (i % 2 == 0) ? "SH" : "SZ");
+        dict.AddFieldValue(STEP_HYDM, 600000 + i);
+        dict.AddFieldValue(STEP_HYDMMC, "n=" + std::to_string(i % 100), true);
+        dict.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(dict.ToString());
+    assert(result);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ValueIndex byCode = parsed.BuildIndex(STEP_HYDM);
+    auto buildUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::high_resolution_clock::now() - start)
+                       .count();
+    assert(byCode.Size() == static_cast<size_t>(recordCount));
+    assert(byCode.Duplicates() == 0);
+
+    start = std::chrono::high_resolution_clock::now();
+    long long hits = 0;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        hits += (byCode.Find(std::to_string(600000 + i)) == i);
+    }
+    auto probeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::high_resolution_clock::now() - start)
+                       .count();
+    assert(hits == recordCount);
+    assert(byCode.Find("000001") == -1);
+
+    // Unique模式保留第一条，Multi模式按记录顺序返回所有记录
+    ValueIndex byMarket = parsed.BuildIndex(STEP_SCDM);
+    assert(byMarket.Size() == 2);
+    assert(byMarket.Duplicates() == static_cast<size_t>(recordCount - 2));
+    assert(byMarket.Find("SZ") == 1);
+
+    ValueIndex byName = parsed.BuildIndex(STEP_HYDMMC, ValueIndex::Mode::Multi);
+    assert(byName.Size() == 100);
+    auto rows = byName.FindAll("n=7");
+    assert(rows.second - rows.first == recordCount / 100);
+    for (const uint32_t *row = rows.first; row != rows.second; ++row)
+    {
+        assert(*row % 100 == 7);
+        assert(row == rows.first || *row > *(row - 1));
+    }
+    assert(byName.FindAll("n=100").first == nullptr);
+
+    // 修改后的值重新建立索引可见
+    parsed.GotoFirst();
+    result = parsed.SetFieldValue(STEP_HYDM, "999999");
+    assert(result);
+    assert(parsed.BuildIndex(STEP_HYDM).Find("999999") == 0);
+
+    std::cout << "Built index over " << recordCount << " rows in " << buildUs << " us, "
+              << recordCount << " probes in " << probeUs << " us" << std::endl;
+    std::cout << "Value index test passed!" << std::endl;
+}
+
+void TestSortBy()
+{
+    std::cout << "Testing record sorting..." << std::endl;
+
+    const int recordCount = 100000;
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, 600000 + (i * 7919) % recordCount);
+        if (i % 1000 != 0) // 部分记录没有价格字段
+        {
+            step.AddFieldValue(STEP_XQJG, std::to_string((i * 31) % 2001 - 1000) + ".5");
+        }
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+    const size_t poolBefore = parsed.PoolUsedSize();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    parsed.SortBy(STEP_XQJG, SortKey::Numeric, SortOrder::Asc);
+    auto sortUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::high_resolution_clock::now() - start)
+                      .count();
+
+    // 只重排索引，不拷贝记录
+    assert(parsed.PoolUsedSize() == poolBefore);
+    assert(parsed.RecordsCount() == recordCount);
+
+    PackageView view = parsed.View();
+    double last = -1e9;
+    int lastCode = -1;
+    int i = 0;
+    for (RecordRef record : view)
+    {
+        std::string price = record.GetStepValueByID(STEP_XQJG);
+        if (i >= recordCount - recordCount / 1000)
+        {
+            // 没有价格的记录按原顺序排在最后
+            assert(price.empty());
+            int code = std::stoi(record.GetStepValueByID(STEP_HYDM));
+            assert(code != lastCode);
+            lastCode = code;
+        }
+        else
+        {
+            double value = std::stod(price);
+            assert(value >= last);
+            last = value;
+        }
+        ++i;
+    }
+    assert(RecordRef(&parsed, 0).GetStepValueByID(STEP_XQJG) == "-1000.5");
+
+    // 字典序降序
+    parsed.SortBy(STEP_HYDM, SortKey::Lexical, SortOrder::Desc);
+    assert(parsed.GetStepValueByID(STEP_HYDM) == "699999");
+    parsed.GotoNext();
+    assert(parsed.GetStepValueByID(STEP_HYDM) == "699998");
+
+    // 补丁随记录移动
+    parsed.GotoFirst();
+    result = parsed.SetFieldValue(STEP_XQJG, "5000");
+    assert(result);
+    parsed.TopK(STEP_XQJG, 3, SortKey::Numeric, SortOrder::Desc);
+    assert(parsed.RecordsCount() == 3);
+    assert(parsed.GetStepValueByID(STEP_HYDM) == "699999");
+    assert(parsed.GetStepValueByID(STEP_XQJG) == "5000");
+    parsed.GotoNext();
+    assert(parsed.GetStepValueByID(STEP_XQJG) == "1000.5");
+
+    // 数值与字典序的区别
+    CachedGatePBStep small;
+    small.Init();
+    const char *prices[] = {"10", "9", "-2", "abc", "1.25e0", "+3"};
+    for (const char *price : prices)
+    {
+        small.AppendRecord();
+        small.AddFieldValue(STEP_XQJG, price);
+        small.EndAppendRecord();
+    }
+    small.SortBy(STEP_XQJG, SortKey::Numeric);
+    assert(small.GetStepValueByID(STEP_XQJG) == "-2");
+    small.GotoNext();
+    assert(small.GetStepValueByID(STEP_XQJG) == "+3");
+    small.SortBy(STEP_XQJG, SortKey::Lexical);
+    assert(small.GetStepValueByID(STEP_XQJG) == "+3");
+    small.GotoNext();
+    assert(small.GetStepValueByID(STEP_XQJG) == "-2");
+    small.GotoNext();
+    assert(small.GetStepValueByID(STEP_XQJG) == "1.25e0");
+
+    // 截取为空后与新建的包一样没有当前记录，追加的记录成为当前记录
+    small.TopK(STEP_XQJG, 0);
+    assert(small.RecordsCount() == 0 && small.GetStepValueByID(STEP_XQJG).empty());
+    small.AppendRecord();
+    small.AddFieldValue(STEP_XQJG, "7");
+    small.EndAppendRecord();
+    assert(small.GetStepValueByID(STEP_XQJG) == "7");
+
+    double number = 0;
+    result = ParseDecimal(Span("-12.050", 7), number);
+    assert(result && number == -12.05);
+    result = ParseDecimal(Span("1.2.3", 5), number);
+    assert(!result);
+    result = ParseDecimal(Span("-", 1), number);
+    assert(!result);
+
+    std::cout << "Sorted " << recordCount << " records by numeric key in " << sortUs << " us" << std::endl;
+    std::cout << "Record sorting test passed!" << std::endl;
+}
+
+void TestRecordFilter()
+{
+    std::cout << "Testing record filter..." << std::endl;
+
+    const int recordCount = 100000;
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, (i % 2 == 0) ? "SH" : "SZ");
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        step.AddFieldValue(STEP_XQJG, std::to_string(i % 1000) + ".25");
+        step.AddFieldValue(STEP_WTSX, std::to_string(i % 5));
+        step.AddFieldValue(STEP_HYDMMC, (i % 7 == 0) ? "a&b" : "ab", true);
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+
+    RecordFilter filter;
+    filter.Equal(STEP_SCDM, "SH").Range(STEP_XQJG, 100, 200).In(STEP_WTSX, {"3", "1"});
+
+    int expected = 0;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        double price = i % 1000 + 0.25;
+        expected += (i % 2 == 0 && price >= 100 && price <= 200 && (i % 5 == 1 || i % 5 == 3));
+    }
+
+    // 只申请结果的记录序号表，随命中数成倍增长
+    size_t growth = 1;
+    for (int n = 1; n < expected; n *= 2)
+    {
+        ++growth;
+    }
+    size_t before = g_heapAllocations;
+    auto start = std::chrono::high_resolution_clock::now();
+    PackageView selected = filter.Apply(parsed);
+    auto filterUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+    size_t allocations = g_heapAllocations - before;
+    assert(allocations <= 2 + growth);
+
+    assert(selected.RecordsCount() == static_cast<size_t>(expected));
+    for (RecordRef record : selected)
+    {
+        size_t i = record.Index();
+        assert(record.GetStepValueByID(STEP_HYDM) == std::to_string(600000 + i));
+        assert(i % 2 == 0 && i % 1000 >= 100 && i % 1000 <= 199);
+    }
+    // 记录数据引用原包
+    assert(selected.Record(0).data == parsed.View().Record(selected.SourceIndex(0)).data);
+
+    // 结果可以再次筛选，比较值按转义后的原始数据比较
+    RecordFilter byName;
+    byName.Equal(STEP_HYDMMC, "a&b");
+    PackageView narrowed = byName.Apply(selected);
+    assert(narrowed.RecordsCount() > 0);
+    for (size_t i = 0; i < narrowed.RecordsCount(); ++i)
+    {
+        assert(narrowed.SourceIndex(i) % 14 == 0);
+    }
+
+    // 游标读取筛选结果，修改过的值参与筛选
+    RecordCursor cursor = narrowed.Cursor();
+    assert(cursor.GetStepValueByID(STEP_HYDMMC) == "a&b");
+    assert(cursor.GetStepValueByID(STEP_HYDM) == std::to_string(600000 + narrowed.SourceIndex(0)));
+
+    parsed.GotoFirst();
+    result = parsed.SetFieldValue(STEP_XQJG, "150");
+    assert(result);
+    PackageView patched = filter.Apply(parsed);
+    assert(patched.RecordsCount() == static_cast<size_t>(expected));
+    parsed.GotoNext();
+    parsed.GotoNext();
+    result = parsed.SetFieldValue(STEP_WTSX, "3");
+    assert(result);
+    assert(filter.Apply(parsed).RecordsCount() == static_cast<size_t>(expected));
+    result = parsed.SetFieldValue(STEP_XQJG, "150");
+    assert(result);
+    assert(filter.Apply(parsed).RecordsCount() == static_cast<size_t>(expected + 1));
+
+    assert(RecordFilter().Apply(parsed).RecordsCount() == static_cast<size_t>(recordCount));
+    assert(RecordFilter().Equal(STEP_XXNR, "").Apply(parsed).RecordsCount() == 0);
+
+    std::cout << "Filtered " << recordCount << " records in " << filterUs << " us, selected "
+              << selected.RecordsCount() << std::endl;
+    std::cout << "Record filter test passed!" << std::endl;
+}
+
+void TestMerge()
+{
+    std::cout << "Testing zero-copy merge..." << std::endl;
+
+    auto makeNode = [](int first, int count, int total)
+    {
+        CachedGatePBStep step;
+        step.Init();
+        step.SetBaseFieldValueInt(STEP_FUNC, 1001);
+        step.SetBaseFieldValueInt(STEP_RETURNNUM, count);
+        if (total > 0)
+        {
+            step.SetBaseFieldValueInt(STEP_TOTALNUM, total);
+        }
+        for (int i = first; i < first + count; ++i)
+        {
+            step.AppendRecord();
+            step.AddFieldValue(STEP_HYDM, 600000 + i);
+            step.AddFieldValue(STEP_HYDMMC, "n=" + std::to_string(i), true);
+            step.EndAppendRecord();
+        }
+        return step.ToString();
+    };
+
+    CachedGatePBStep nodeA, nodeB, nodeC;
+    bool result = nodeA.SetPackage(makeNode(0, 3000, 10000));
+    assert(result);
+    result = nodeB.SetPackage(makeNode(3000, 2000, 0));
+    assert(result);
+    result = nodeC.SetPackage(makeNode(5000, 2, 2)); // 内联存放的小包
+    assert(result);
+
+    // 合并前的修改随记录带过来
+    nodeB.GotoFirst();
+    result = nodeB.SetFieldValue(STEP_XQJG, "12.5");
+    assert(result);
+
+    Span firstA = nodeA.View().Record(0);
+    std::string expectedBody;
+    for (CachedGatePBStep *node : {&nodeA, &nodeB, &nodeC})
+    {
+        std::string text = node->ToString();
+        expectedBody += text.substr(text.find('\n') + 1);
+    }
+
+    CachedGatePBStep merged;
+    merged.Init();
+    size_t before = g_heapAllocations;
+    merged.Merge(nodeA, nodeB, nodeC);
+    size_t allocations = g_heapAllocations - before;
+
+    assert(merged.RecordsCount() == 5002);
+    assert(merged.GetBaseFieldValue(STEP_FUNC) == "1001");
+    assert(merged.GetBaseFieldValue(STEP_RETURNNUM) == "5002");
+    assert(merged.GetBaseFieldValue(STEP_TOTALNUM) == std::to_string(10000 + 2000 + 2));
+
+    // 记录数据不拷贝，内联的小包除外
+    assert(merged.View().Record(0).data == firstA.data);
+    assert(merged.PoolUsedSize() < 1024);
+
+    std::string text = merged.ToString();
+    assert(text.substr(text.find('\n') + 1) == expectedBody);
+
+    // 来源包重置或修改后，合并结果不受影响
+    nodeA.Init();
+    result = nodeB.SetFieldValue(STEP_XQJG, "99");
+    assert(result);
+    assert(nodeB.GetStepValueByID(STEP_HYDMMC) == "n=3000");
+    assert(merged.ToString() == text);
+
+    RecordRef patched(&merged, 3000);
+    assert(patched.GetStepValueByID(STEP_XQJG) == "12.5");
+    assert(RecordRef(&merged, 5001).GetStepValueByID(STEP_HYDMMC) == "n=5001");
+
+    // 合并结果可以再次合并，Init后释放共享的内存池
+    CachedGatePBStep outer;
+    outer.Init();
+    outer.Merge(merged);
+    merged.Init();
+    assert(outer.RecordsCount() == 5002);
+    assert(outer.GetStepValueByID(STEP_HYDM) == "600000");
+    assert(outer.GetBaseFieldValue(STEP_TOTALNUM) == "12002");
+
+    // 总记录数之和超出int范围时不截断
+    CachedGatePBStep bigA, bigB, bigMerged;
+    result = bigA.SetPackage(makeNode(0, 2, 2000000000));
+    assert(result);
+    result = bigB.SetPackage(makeNode(2, 2, 2000000000));
+    assert(result);
+    bigMerged.Init();
+    bigMerged.Merge(bigA, bigB);
+    assert(bigMerged.RecordsCount() == 4);
+    assert(bigMerged.GetBaseFieldValue(STEP_TOTALNUM) == "4000000000");
+
+    // 压缩的来源包先解压再计数，没有STEP_TOTALNUM时按记录数计
+    CachedGatePBStep packed, withPacked;
+    result = packed.SetPackage(makeNode(7000, 600, 0));
+    assert(result);
+    result = packed.Compress();
+    assert(result);
+    withPacked.Init();
+    withPacked.SetBaseFieldValueInt(STEP_FUNC, 1001);
+    withPacked.Merge(bigA, packed);
+    assert(!packed.IsCompressed());
+    assert(withPacked.RecordsCount() == 602);
+    assert(withPacked.GetBaseFieldValue(STEP_TOTALNUM) == "2000000600");
+    assert(withPacked.FormatedRecords(2, 3) == packed.FormatedRecords(0, 1));
+
+    std::cout << "Merged 5002 records with " << allocations << " allocations" << std::endl;
+    std::cout << "Zero-copy merge test passed!" << std::endl;
+}
+
+void TestSortedMerge()
+{
+    std::cout << "Testing k-way sorted merge..." << std::endl;
+
+    // 三个后端各自按委托时间升序返回，时间交错
+    const int perNode = 30000;
+    CachedGatePBStep nodes[3];
+    for (int n = 0; n < 3; ++n)
+    {
+        CachedGatePBStep node;
+        node.Init();
+        node.SetBaseFieldValueInt(STEP_FUNC, 2001);
+        node.SetBaseFieldValueInt(STEP_RETURNNUM, perNode);
+        node.SetBaseFieldValueInt(STEP_TOTALNUM, perNode * 10);
+        node.SetBaseFieldValueString(STEP_MSG, "node=" + std::to_string(n));
+        for (int i = 0; i < perNode; ++i)
+        {
+            node.AppendRecord();
+            node.AddFieldValue(STEP_HYDM, n);
+            node.AddFieldValue(STEP_XXNR, 93000000 + i * 3 + n);
+            node.EndAppendRecord();
+        }
+        bool result = nodes[n].SetPackage(node.ToString());
+        assert(result);
+    }
+
+    SortedMerge merge(STEP_XXNR, SortKey::Numeric);
+    for (auto &node : nodes)
+    {
+        merge.Add(node);
+    }
+    assert(merge.RecordsCount() == static_cast<size_t>(perNode * 3));
+
+    // 第一页
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string firstPage = merge.ToString(100);
+    auto pageUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::high_resolution_clock::now() - start)
+                      .count();
+
+    CachedGatePBStep page;
+    bool result = page.SetPackage(firstPage);
+    assert(result);
+    assert(page.RecordsCount() == 100);
+    assert(page.GetBaseFieldValue(STEP_RETURNNUM) == "100");
+    assert(page.GetBaseFieldValue(STEP_TOTALNUM) == std::to_string(perNode * 30));
+    assert(page.GetBaseFieldValue(STEP_FUNC) == "2001");
+    assert(page.GetBaseFieldValue(STEP_MSG) == "node=0");
+    for (int i = 0; i < 100; ++i, page.GotoNext())
+    {
+        assert(page.GetStepValueByID(STEP_XXNR) == std::to_string(93000000 + i));
+        assert(page.GetStepValueByID(STEP_HYDM) == std::to_string(i % 3));
+    }
+
+    // 第二页接着第一页，返回数只计本页
+    RecordRef skipped;
+    result = merge.Next(skipped);
+    assert(result);
+    result = page.SetPackage(merge.ToString(perNode));
+    assert(result);
+    assert(page.RecordsCount() == perNode);
+    assert(page.GetBaseFieldValue(STEP_RETURNNUM) == std::to_string(perNode));
+    assert(page.GetStepValueByID(STEP_XXNR) == std::to_string(93000000 + 101));
+    result = page.SetPackage(merge.ToString());
+    assert(result);
+    assert(page.RecordsCount() == perNode * 2 - 101);
+    assert(page.GetBaseFieldValue(STEP_RETURNNUM) == std::to_string(perNode * 2 - 101));
+
+    // 全部归并
+    SortedMerge full(STEP_XXNR, SortKey::Numeric);
+    for (auto &node : nodes)
+    {
+        full.Add(node);
+    }
+    start = std::chrono::high_resolution_clock::now();
+    long long last = 0;
+    size_t count = full.ForEach([&last](const RecordRef &record)
+                                {
+                                    long long time = std::stoll(record.GetStepValueByID(STEP_XXNR));
+                                    assert(time == last + 1 || last == 0);
+                                    last = time;
+                                });
+    auto fullUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::high_resolution_clock::now() - start)
+                      .count();
+    assert(count == static_cast<size_t>(perNode * 3));
+    RecordRef record;
+    result = full.Next(record);
+    assert(!result);
+
+    // 字典序降序，相等时先取前面的来源，没有字段的排在最后；修改过的值参与比较
+    CachedGatePBStep left, right;
+    left.Init();
+    right.Init();
+    const char *leftCodes[] = {"c", "b", "a"};
+    const char *rightCodes[] = {"d", "b", nullptr};
+    for (int i = 0; i < 3; ++i)
+    {
+        left.AppendRecord();
+        left.AddFieldValue(STEP_HYDMMC, leftCodes[i]);
+        left.AddFieldValue(STEP_SCDM, "L");
+        left.EndAppendRecord();
+        right.AppendRecord();
+        if (rightCodes[i] != nullptr)
+        {
+            right.AddFieldValue(STEP_HYDMMC, rightCodes[i]);
+        }
+        right.AddFieldValue(STEP_SCDM, "R");
+        right.EndAppendRecord();
+    }
+    left.GotoFirst();
+    result = left.SetFieldValue(STEP_HYDMMC, "e");
+    assert(result);
+
+    SortedMerge desc(STEP_HYDMMC, SortKey::Lexical, SortOrder::Desc);
+    desc.Add(left);
+    desc.Add(right);
+    std::string order;
+    desc.ForEach([&order](const RecordRef &record)
+                 { order += record.GetStepValueByID(STEP_SCDM) + record.GetStepValueByID(STEP_HYDMMC) + " "; });
+    assert(order == "Le Rd Lb Rb La R ");
+
+    std::cout << "First page of " << perNode * 3 << " records in " << pageUs << " us, full merge in "
+              << fullUs << " us" << std::endl;
+    std::cout << "K-way sorted merge test passed!" << std::endl;
+}
+
+void TestSplitBySize()
+{
+    std::cout << "Testing size-bounded splitting..." << std::endl;
+
+    const int recordCount = 20000;
+    CachedGatePBStep step;
+    step.Init();
+    step.SetBaseFieldValueInt(STEP_FUNC, 3001);
+    step.SetBaseFieldValueInt(STEP_RETURNNUM, recordCount);
+    step.SetBaseFieldValueInt(STEP_TOTALNUM, recordCount);
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        step.AddFieldValue(STEP_HYDMMC, std::string(i % 50, 'x') + "&", true);
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+    parsed.GotoFirst();
+    parsed.GotoNext();
+    result = parsed.SetFieldValue(STEP_XQJG, "1.5");
+    assert(result);
+
+    const size_t maxBytes = 16 * 1024;
+    PackageFrames frames;
+    size_t before = parsed.PoolUsedSize();
+    result = parsed.SplitBySize(maxBytes, frames);
+    assert(result);
+    assert(parsed.PoolUsedSize() == before);
+    assert(frames.FramesCount() > 1);
+
+    // 各帧拼起来就是原来的全部记录，每帧都能独立解包
+    int next = 0;
+    for (size_t f = 0; f < frames.FramesCount(); ++f)
+    {
+        std::string text = frames.ToString(f);
+        assert(text.size() == frames.Bytes(f));
+        assert(frames.Bytes(f) <= maxBytes);
+        assert(frames.IovCount(f) == 1 + 2 * frames.RecordsCount(f));
+        if (f + 1 < frames.FramesCount())
+        {
+            assert(frames.Bytes(f) > maxBytes - 128);
+        }
+
+        CachedGatePBStep frame;
+        result = frame.SetPackage(text);
+        assert(result);
+        assert(frame.RecordsCount() == static_cast<int>(frames.RecordsCount(f)));
+        assert(frame.GetBaseFieldValue(STEP_RETURNNUM) == std::to_string(frames.RecordsCount(f)));
+        assert(frame.GetBaseFieldValue(STEP_TOTALNUM) == std::to_string(recordCount));
+        assert(frame.GetBaseFieldValue(STEP_FUNC) == "3001");
+        for (int i = 0; i < frame.RecordsCount(); ++i, ++next, frame.GotoNext())
+        {
+            assert(frame.GetStepValueByID(STEP_HYDM) == std::to_string(600000 + next));
+            assert(frame.GetStepValueByID(STEP_HYDMMC) == std::string(next % 50, 'x') + "&");
+            assert(frame.GetStepValueByID(STEP_XQJG) == (next == 1 ? "1.5" : ""));
+        }
+    }
+    assert(next == recordCount);
+    size_t frameCount = frames.FramesCount();
+
+    // 记录直接引用原包的数据
+    assert(frames.Iov(0)[1].iov_base == parsed.View().Record(0).data);
+
+    // 一条记录也放不下时失败
+    result = parsed.SplitBySize(64, frames);
+    assert(!result);
+    assert(frames.FramesCount() == 0);
+
+    CachedGatePBStep empty;
+    empty.Init();
+    empty.SetBaseFieldValueInt(STEP_FUNC, 3001);
+    result = empty.SplitBySize(maxBytes, frames);
+    assert(result);
+    assert(frames.FramesCount() == 1);
+    assert(frames.ToString(0) == "3=3001&6=0&\n");
+
+    std::cout << "Split " << recordCount << " records into " << frameCount << " frames" << std::endl;
+    std::cout << "Size-bounded splitting test passed!" << std::endl;
+}
+
+void TestColumns()
+{
+    std::cout << "Testing columnar materialization..." << std::endl;
+
+    const int recordCount = 100000;
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, (i % 3 == 0) ? "SH" : ((i % 3 == 1) ? "SZ" : "B&J"), true);
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        if (i % 100 != 0) // 部分记录没有保证金字段
+        {
+            step.AddFieldValue(STEP_DWBZJ, std::to_string(i) + "." + std::to_string(i % 100));
+        }
+        step.AddFieldValue(STEP_XQJG, (i % 1000 == 1) ? "-" : std::to_string(i % 500) + ".125");
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+    parsed.GotoFirst();
+    result = parsed.SetFieldValue(STEP_DWBZJ, "0.5");
+    assert(result);
+
+    const std::vector<ColumnSpec> specs = {{STEP_HYDM, ColumnType::Int64},
+                                           {STEP_DWBZJ, ColumnType::Double},
+                                           {STEP_XQJG, ColumnType::Double},
+                                           {STEP_SCDM, ColumnType::String}};
+    auto start = std::chrono::high_resolution_clock::now();
+    ColumnSet columns = parsed.ToColumns(specs);
+    auto columnUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+
+    // 逐个字段读取作为对照
+    start = std::chrono::high_resolution_clock::now();
+    double expectedMargin = 0;
+    parsed.GotoFirst();
+    for (int i = 0; i < recordCount; ++i, parsed.GotoNext())
+    {
+        expectedMargin += atof(parsed.GetStepValueByID(STEP_DWBZJ).c_str());
+    }
+    auto cellUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::high_resolution_clock::now() - start)
+                      .count();
+
+    assert(columns.RowsCount() == static_cast<size_t>(recordCount));
+    assert(columns.ColumnsCount() == 4);
+
+    const Column &code = columns[0];
+    for (int i = 0; i < recordCount; ++i)
+    {
+        assert(!code.IsNull(i) && code.Int64Data()[i] == 600000 + i);
+    }
+
+    const Column &margin = *columns.Find(STEP_DWBZJ);
+    assert(margin.NullCount() == static_cast<size_t>(recordCount / 100 - 1));
+    assert(!margin.IsNull(0) && margin.DoubleData()[0] == 0.5);
+    assert(margin.IsNull(100) && margin.DoubleData()[100] == 0);
+    assert(margin.DoubleData()[12345] == 12345.45);
+    double sum = 0;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        sum += margin.DoubleData()[i];
+    }
+    assert(sum == expectedMargin);
+
+    const Column &price = *columns.Find(STEP_XQJG);
+    assert(price.NullCount() == static_cast<size_t>(recordCount / 1000));
+    assert(price.IsNull(1) && !price.IsNull(2));
+    assert(price.DoubleData()[2] == 2.125);
+
+    const Column &market = *columns.Find(STEP_SCDM);
+    assert(market.DictionarySize() == 3);
+    assert(market.Dictionary(market.Codes()[0]) == "SH");
+    assert(market.Dictionary(market.Codes()[2]) == "B&J");
+    assert(market.Codes()[3] == market.Codes()[0]);
+    assert(columns.Find(STEP_XXNR) == nullptr);
+
+    // 反向：由列生成记录
+    CachedGatePBStep rebuilt;
+    rebuilt.Init();
+    rebuilt.AppendColumns(columns);
+    assert(rebuilt.RecordsCount() == recordCount);
+    rebuilt.GotoFirst();
+    assert(rebuilt.GetStepValueByID(STEP_DWBZJ) == "0.5");
+    rebuilt.GotoNext();
+    assert(rebuilt.GetStepValueByID(STEP_XQJG) == "");
+    rebuilt.GotoNext();
+    assert(rebuilt.GetStepValueByID(STEP_SCDM) == "B&J");
+
+    ColumnSet again = rebuilt.ToColumns(specs);
+    for (size_t c = 0; c < specs.size(); ++c)
+    {
+        assert(again[c].NullCount() == columns[c].NullCount());
+    }
+    for (int i = 0; i < recordCount; ++i)
+    {
+        assert(again[1].DoubleData()[i] == margin.DoubleData()[i]);
+        assert(again[2].DoubleData()[i] == price.DoubleData()[i]);
+        assert(again[3].Dictionary(again[3].Codes()[i]) == market.Dictionary(market.Codes()[i]));
+    }
+
+    // 手工组装的列
+    ColumnSet manual;
+    Column &qty = manual.AddColumn(STEP_HYDM, ColumnType::Int64);
+    Column &name = manual.AddColumn(STEP_HYDMMC, ColumnType::String);
+    qty.AppendInt64(-5);
+    qty.AppendNull();
+    name.AppendString("a=b");
+    name.AppendString("a=b");
+    name.AppendString("c");
+    assert(manual.RowsCount() == 3 && name.DictionarySize() == 2);
+    CachedGatePBStep small;
+    small.Init();
+    small.AppendColumns(manual);
+    assert(small.FormatedRecords(0, 3) == "63=-5&64=a\\ab&\n64=a\\ab&\n64=c&\n");
+
+    std::cout << "Columns of " << recordCount << " records in " << columnUs << " us, per-cell reads of one field in "
+              << cellUs << " us" << std::endl;
+    std::cout << "Columnar materialization test passed!" << std::endl;
+}
+
+void TestAggregate()
+{
+    std::cout << "Testing aggregation kernels..." << std::endl;
+
+    const int recordCount = 50000;
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, (i % 3 == 0) ? "SH" : ((i % 3 == 1) ? "SZ" : "BJ"));
+        step.AddFieldValue(STEP_HYDM, (i * 7919) % 100003 - 50000);
+        if (i % 97 != 0)
+        {
+            step.AddFieldValue(STEP_DWBZJ, std::to_string(i % 1000) + "." + std::to_string(i % 10) + "5");
+        }
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+
+    // 对照：逐条记录读取
+    size_t count = 0;
+    double sum = 0, low = 1e300, high = -1e300;
+    long long intSum = 0, intLow = 1LL << 62, intHigh = -(1LL << 62);
+    parsed.GotoFirst();
+    for (int i = 0; i < recordCount; ++i, parsed.GotoNext())
+    {
+        std::string margin = parsed.GetStepValueByID(STEP_DWBZJ);
+        if (!margin.empty())
+        {
+            double value = atof(margin.c_str());
+            ++count;
+            sum += value;
+            low = std::min(low, value);
+            high = std::max(high, value);
+        }
+        long long code = atoll(parsed.GetStepValueByID(STEP_HYDM).c_str());
+        intSum += code;
+        intLow = std::min(intLow, code);
+        intHigh = std::max(intHigh, code);
+    }
+
+    ColumnSet columns = parsed.ToColumns({{STEP_SCDM, ColumnType::String},
+                                          {STEP_DWBZJ, ColumnType::Double},
+                                          {STEP_HYDM, ColumnType::Int64}});
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Summary margin = Summarize(columns[1]);
+    auto kernelUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+    assert(margin.count == count);
+    assert(std::fabs(margin.sum - sum) < 1e-6 * sum);
+    assert(margin.min == low && margin.max == high);
+    assert(std::fabs(margin.Mean() - sum / count) < 1e-9 * sum);
+
+    Summary code = Summarize(columns[2]);
+    assert(code.count == static_cast<size_t>(recordCount));
+    assert(code.sum == static_cast<double>(intSum));
+    assert(code.min == static_cast<double>(intLow) && code.max == static_cast<double>(intHigh));
+
+    Summary direct = Summarize(parsed, STEP_DWBZJ);
+    assert(direct.count == margin.count && direct.sum == margin.sum);
+
+    // 按市场分组
+    auto byMarket = SummarizeBy(parsed, STEP_SCDM, STEP_DWBZJ);
+    assert(byMarket.size() == 3);
+    assert(byMarket[0].first == "SH" && byMarket[1].first == "SZ" && byMarket[2].first == "BJ");
+    size_t groupCount = 0;
+    double groupSum = 0;
+    for (const auto &group : byMarket)
+    {
+        groupCount += group.second.count;
+        groupSum += group.second.sum;
+        assert(group.second.min >= low && group.second.max <= high);
+    }
+    assert(groupCount == count);
+    assert(std::fabs(groupSum - sum) < 1e-6 * sum);
+
+    // 空列和字符串列
+    Summary none = Summarize(parsed, STEP_XXNR);
+    assert(none.count == 0 && none.sum == 0 && none.min == 0 && none.max == 0);
+    assert(Summarize(columns[0]).count == static_cast<size_t>(recordCount));
+
+    std::cout << "Summarized " << recordCount << " values in " << kernelUs << " us" << std::endl;
+    std::cout << "Aggregation kernels test passed!" << std::endl;
+}
+
+void TestInternFields()
+{
+    std::cout << "Testing interned field dictionaries..." << std::endl;
+
+    const int recordCount = 100000;
+    const char *markets[] = {"SH", "SZ", "BJ", "H&K"};
+    CachedGatePBStep step;
+    step.Init();
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, markets[i % 4], true);
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        if (i % 10 != 0)
+        {
+            step.AddFieldValue(STEP_WTSX, std::to_string(i % 3));
+        }
+        step.AddFieldValue(STEP_XQJG, std::to_string(i % 200) + ".5");
+        step.EndAppendRecord();
+    }
+
+    CachedGatePBStep parsed;
+    bool result = parsed.SetPackage(step.ToString());
+    assert(result);
+    const std::string before = parsed.ToString();
+
+    RecordFilter filter;
+    filter.Equal(STEP_SCDM, "H&K").In(STEP_WTSX, {"0", "2"});
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t plain = filter.Apply(parsed).RecordsCount();
+    auto plainUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::high_resolution_clock::now() - start)
+                       .count();
+
+    parsed.InternFields({STEP_SCDM, STEP_WTSX});
+    const InternedField *market = parsed.Interned().Find(STEP_SCDM);
+    assert(market != nullptr && parsed.Interned().Find(STEP_HYDM) == nullptr);
+    assert(market->DictionarySize() == 4);
+    assert(market->RecordsCount() == static_cast<size_t>(recordCount));
+    assert(market->CodeOf("H&K") == 3 && market->Value(3) == "H\\bK");
+    assert(market->Codes()[7] == 3 && market->CodeOf("HK") == InternedField::kNull);
+    const InternedField *flag = parsed.Interned().Find(STEP_WTSX);
+    assert(flag->Codes()[10] == InternedField::kNull);
+
+    // 记录数据不变
+    assert(parsed.ToString() == before);
+
+    // 条件全部按编码比较，不扫描记录
+    start = std::chrono::high_resolution_clock::now();
+    PackageView coded = filter.Apply(parsed);
+    auto codedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::high_resolution_clock::now() - start)
+                       .count();
+    assert(coded.RecordsCount() == plain);
+    for (RecordRef record : coded)
+    {
+        assert(record.GetStepValueByID(STEP_SCDM) == "H&K");
+        std::string value = record.GetStepValueByID(STEP_WTSX);
+        assert(value == "0" || value == "2");
+    }
+
+    // 混合条件
+    RecordFilter mixed;
+    mixed.Equal(STEP_SCDM, "SZ").Range(STEP_XQJG, 0, 50);
+    size_t expected = 0;
+    for (int i = 0; i < recordCount; ++i)
+    {
+        expected += (i % 4 == 1 && i % 200 < 50);
+    }
+    assert(mixed.Apply(parsed).RecordsCount() == expected);
+    assert(RecordFilter().Equal(STEP_SCDM, "NY").Apply(parsed).RecordsCount() == 0);
+
+    // 修改和排序后编码同步
+    parsed.GotoFirst();
+    result = parsed.SetFieldValue(STEP_SCDM, "NY");
+    assert(result);
+    assert(market->DictionarySize() == 5 && market->Codes()[0] == 4);
+    assert(RecordFilter().Equal(STEP_SCDM, "NY").Apply(parsed).RecordsCount() == 1);
+
+    parsed.SortBy(STEP_HYDM, SortKey::Numeric, SortOrder::Desc);
+    market = parsed.Interned().Find(STEP_SCDM);
+    assert(market->Codes()[recordCount - 1] == 4);
+    assert(market->Codes()[0] == market->CodeOf(markets[(recordCount - 1) % 4]));
+
+    // 按列读取沿用编码
+    ColumnSet columns = parsed.ToColumns({{STEP_SCDM, ColumnType::String}, {STEP_XQJG, ColumnType::Double}});
+    assert(columns[0].DictionarySize() == 5);
+    assert(columns[0].Dictionary(columns[0].Codes()[recordCount - 1]) == "NY");
+    assert(columns[1].DoubleData()[recordCount - 1] == 0.5);
+    auto byMarket = SummarizeBy(parsed, STEP_SCDM, STEP_XQJG);
+    assert(byMarket.size() == 5 && byMarket[4].first == "NY" && byMarket[4].second.count == 1);
+
+    // 压缩后按原字段重建，新增记录后清空
+    parsed.Compact();
+    assert(parsed.Interned().Find(STEP_SCDM) != nullptr);
+    assert(RecordFilter().Equal(STEP_SCDM, "NY").Apply(parsed).RecordsCount() == 1);
+    parsed.AppendRecord();
+    assert(parsed.Interned().Empty());
+
+    // 截取、修改后按列读取与未编码时一致
+    CachedGatePBStep small, smallInterned;
+    small.Init();
+    for (int i = 0; i < 6; ++i)
+    {
+        small.AppendRecord();
+        small.AddFieldValue(STEP_SCDM, markets[i % 3], true);
+        small.AddFieldValue(STEP_XQJG, std::to_string(i));
+        small.EndAppendRecord();
+    }
+    result = smallInterned.SetPackage(small.ToString());
+    assert(result);
+    smallInterned.InternFields({STEP_SCDM});
+    auto sameColumns = [&small, &smallInterned]() {
+        ColumnSet plainColumns = small.ToColumns({{STEP_SCDM, ColumnType::String}});
+        ColumnSet codedColumns = smallInterned.ToColumns({{STEP_SCDM, ColumnType::String}});
+        const Column &lhs = plainColumns[0];
+        const Column &rhs = codedColumns[0];
+        assert(lhs.DictionarySize() == rhs.DictionarySize());
+        for (uint32_t code = 0; code < lhs.DictionarySize(); ++code)
+        {
+            assert(lhs.Dictionary(code) == rhs.Dictionary(code));
+        }
+        for (int row = 0; row < small.RecordsCount(); ++row)
+        {
+            assert(lhs.Codes()[row] == rhs.Codes()[row]);
+        }
+        auto plainGroups = SummarizeBy(small, STEP_SCDM, STEP_XQJG);
+        auto codedGroups = SummarizeBy(smallInterned, STEP_SCDM, STEP_XQJG);
+        assert(plainGroups.size() == codedGroups.size());
+        for (size_t i = 0; i < plainGroups.size(); ++i)
+        {
+            assert(plainGroups[i].first == codedGroups[i].first);
+            assert(plainGroups[i].second.count == codedGroups[i].second.count);
+            assert(plainGroups[i].second.sum == codedGroups[i].second.sum);
+        }
+        return plainGroups;
+    };
+    small.TopK(STEP_XQJG, 2, SortKey::Numeric, SortOrder::Desc);
+    smallInterned.TopK(STEP_XQJG, 2, SortKey::Numeric, SortOrder::Desc);
+    auto topGroups = sameColumns();
+    assert(topGroups.size() == 2 && topGroups[0].first == "BJ" && topGroups[1].first == "SZ");
+    small.GotoFirst();
+    smallInterned.GotoFirst();
+    result = small.SetFieldValue(STEP_SCDM, "NY") && smallInterned.SetFieldValue(STEP_SCDM, "NY");
+    assert(result);
+    topGroups = sameColumns();
+    assert(topGroups.size() == 2 && topGroups[0].first == "NY" && topGroups[1].first == "SZ");
+
+    std::cout << "Filter on " << recordCount << " records: " << plainUs << " us by text, " << codedUs
+              << " us by codes" << std::endl;
+    std::cout << "Interned field dictionaries test passed!" << std::endl;
+}
+
+void TestCompress()
+{
+    std::cout << "Testing compressed packages..." << std::endl;
+
+    // 编解码：空数据、不可压缩数据、长重复、损坏的输入
+    std::string packed;
+    std::string raw;
+    for (int i = 0; i < 5000; ++i)
+    {
+        raw.push_back(static_cast<char>((i * 7919) ^ (i >> 3)));
+    }
+    raw.append(std::string(3000, 'x'));
+    for (size_t size : {size_t(0), size_t(5), size_t(13), raw.size()})
+    {
+        LzCompress(raw.data(), size, packed);
+        assert(packed.size() <= LzBound(size));
+        std::string restored(size, '\0');
+        bool result = LzDecompress(packed.data(), packed.size(), &restored[0], size);
+        assert(result);
+        assert(restored == raw.substr(0, size));
+    }
+    std::string restored(raw.size(), '\0');
+    bool result = LzDecompress(packed.data(), packed.size() - 1, &restored[0], raw.size());
+    assert(!result);
+    result = LzDecompress(packed.data(), packed.size(), &restored[0], raw.size() - 1);
+    assert(!result);
+
+    const int recordCount = 100000;
+    const char *markets[] = {"SH", "SZ", "BJ", "H&K"};
+    CachedGatePBStep step;
+    step.Init();
+    step.SetBaseFieldValueInt(STEP_RETURNNUM, recordCount);
+    for (int i = 0; i < recordCount; ++i)
+    {
+        step.AppendRecord();
+        step.AddFieldValue(STEP_SCDM, markets[i % 4], true);
+        step.AddFieldValue(STEP_HYDM, 600000 + i);
+        step.AddFieldValue(STEP_WTSX, std::to_string(i % 3));
+        step.AddFieldValue(STEP_XQJG, std::to_string(10 + i % 200) + ".25");
+        step.AddFieldValue(STEP_ZJZH, "100012345678");
+        step.AddFieldValue(STEP_ZQMC, fmt::format("ETF{:03}", i % 50));
+        step.AddFieldValue(STEP_ZQLB, i % 7 == 0 ? "bond" : "stock");
+        step.EndAppendRecord();
+    }
+    step.GotoFirst();
+    result = step.SetFieldValue(STEP_WTSX, "patched");
+    assert(result);
+    step.InternFields({STEP_SCDM});
+
+    const std::string before = step.ToString();
+    const std::string middle = step.FormatedRecords(65000, 65010);
+    const size_t poolBytes = step.PoolUsedSize();
+
+    result = step.Compress();
+    assert(result);
+    assert(step.IsCompressed());
+    result = step.Compress();
+    assert(!result);
+    assert(step.RecordsCount() == recordCount);
+    assert(step.Interned().Empty());
+    PackageFrames frames;
+    result = step.SplitBySize(1 << 20, frames);
+    assert(!result);
+
+    // 压缩期间直接按块解压输出
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string serialized = step.ToString();
+    auto serializeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::high_resolution_clock::now() - start)
+                           .count();
+    assert(serialized == before);
+    assert(step.FormatedRecords(65000, 65010) == middle);
+    assert(step.FormatedRecords(recordCount - 1, recordCount + 5) == before.substr(before.rfind('\n', before.size() - 2) + 1));
+    std::string streamed;
+    size_t writes = 0;
+    step.StreamTo([&streamed, &writes](const struct iovec *iov, int count)
+                  {
+                      for (int i = 0; i < count; ++i)
+                      {
+                          streamed.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+                      }
+                      ++writes;
+                  });
+    assert(streamed == before && writes > 2);
+    assert(step.IsCompressed());
+
+    // const接口不能解压，压缩期间读取记录时抛出异常，不返回空结果
+    size_t rejected = 0;
+    auto expectRejected = [&rejected](const std::function<void()> &read)
+    {
+        try
+        {
+            read();
+        }
+        catch (const std::logic_error &)
+        {
+            ++rejected;
+        }
+    };
+    Span fields[1];
+    const int fieldIds[] = {STEP_HYDM};
+    expectRejected([&step]() { step.View(); });
+    expectRejected([&step, &fields, &fieldIds]() { step.GetFields(fieldIds, 1, fields); });
+    expectRejected([&step]() { step.BuildIndex(STEP_HYDM); });
+    expectRejected([&step]() { step.ToColumns({{STEP_XQJG, ColumnType::Double}}); });
+    expectRejected([&step]() { RecordFilter().Equal(STEP_SCDM, "SH").Apply(step); });
+    expectRejected([&step]() { Summarize(step, STEP_XQJG); });
+    expectRejected([&step]() { SummarizeBy(step, STEP_SCDM, STEP_XQJG); });
+    expectRejected([&step]() { SortedMerge(STEP_HYDM).Add(step); });
+    assert(rejected == 8);
+    assert(step.IsCompressed());
+
+    const size_t compressedBytes = step.CompressedSize();
+    assert(compressedBytes * 4 < poolBytes);
+
+    // 按字段读取时解压整个包并保持解压状态，字典随之重建
+    step.GotoFirst();
+    std::string patched = step.GetStepValueByID(STEP_WTSX);
+    assert(patched == "patched");
+    assert(!step.IsCompressed() && step.CompressedSize() == 0);
+    // 记录全部回到内存池(不含换行)
+    assert(step.PoolUsedSize() >= before.size() - before.find('\n') - 1 - recordCount);
+    assert(step.View().RecordsCount() == static_cast<size_t>(recordCount));
+    assert(step.RecordsCount() == recordCount);
+    assert(step.Interned().Find(STEP_SCDM) != nullptr);
+    assert(RecordFilter().Equal(STEP_SCDM, "H&K").Apply(step).RecordsCount() == recordCount / 4);
+    assert(step.ToString() == before);
+
+    // 再次压缩后修改和追加记录
+    result = step.Compress();
+    assert(result);
+    step.GotoFirst();
+    step.GotoNext();
+    result = step.SetFieldValue(STEP_HYDM, "1");
+    assert(result);
+    assert(!step.IsCompressed());
+    step.AppendRecord();
+    step.AddFieldValue(STEP_HYDM, 1);
+    step.EndAppendRecord();
+    assert(step.RecordsCount() == recordCount + 1);
+    result = step.Compress();
+    assert(result);
+    std::string tail = step.FormatedRecords(recordCount, recordCount + 1);
+    assert(tail == fmt::format("{}=1&\n", STEP_HYDM));
+    step.Decompress();
+    assert(step.View().RecordsCount() == static_cast<size_t>(recordCount + 1));
+
+    // 未压缩时StreamTo与ToString一致，内联小包不压缩
+    streamed.clear();
+    step.StreamTo([&streamed](const struct iovec *iov, int)
+                  { streamed.append(static_cast<const char *>(iov->iov_base), iov->iov_len); });
+    assert(streamed == step.ToString());
+    CachedGatePBStep small;
+    result = small.SetPackage(fmt::format("{}=1&\n{}=SH&\n", STEP_RETURNNUM, STEP_SCDM));
+    assert(result);
+    result = small.Compress();
+    assert(!result);
+
+    std::cout << "Pool " << poolBytes << " bytes, compressed " << compressedBytes << " bytes, ToString "
+              << serializeUs << " us" << std::endl;
+    std::cout << "Compressed packages test passed!" << std::endl;
+}
+
 int main()
 {
     try
@@ -204,6 +1855,25 @@ int main()
         TestSerialization();
         TestEscaping();
         TestPerformance();
+        TestWarmUp();
+        TestCapacityLearning();
+        TestExpectRecords();
+        TestInlinePackage();
+        TestRouteParser();
+        TestPackageView();
+        TestRecordIteration();
+        TestGetFields();
+        TestFieldPatches();
+        TestValueIndex();
+        TestSortBy();
+        TestRecordFilter();
+        TestMerge();
+        TestSortedMerge();
+        TestSplitBySize();
+        TestColumns();
+        TestAggregate();
+        TestInternFields();
+        TestCompress();
         
         std::cout << "\nAll tests passed successfully!" << std::endl;
         return 0;
@@ -10,7 +10,6 @@ MemBlock::MemBlock(size_t capacity)
     {
         throw std::runtime_error("malloc failed.. memory leak");
     }
-    ::memset(m_Mem, 0, capacity);
 
     m_CurrPtr = m_Mem;
 }
@@ -24,49 +23,38 @@ MemBlock::~MemBlock()
     }
 }
 
-int MemBlock::PushBack(const char *pData, size_t nDataLen)
+bool MemBlock::PushBack(const char *pData, size_t nDataLen, int &index)
 {
-    if (nDataLen + m_UsedSize > m_Capacity)
+    if (nDataLen > LeftSize())
     {
-        return -1;
+        return false;
     }
 
     // 拷贝
     ::memcpy(m_CurrPtr, pData, nDataLen);
     // 移位
     m_CurrPtr = m_CurrPtr + nDataLen;
-    m_Blocks.emplace_back(m_UsedSize);
+    m_Blocks.push_back(Item{m_UsedSize, nDataLen, false});
     m_UsedSize += nDataLen;
 
-    return m_Blocks.size() - 1;
+    index = static_cast<int>(m_Blocks.size() - 1);
+    return true;
 }
 
-std::pair<char *, size_t> MemBlock::Get(int index)
+std::pair<const char *, size_t> MemBlock::Get(int index) const
 {
-    size_t usedLen = m_Blocks.at(index);
-    char *ptr = m_Mem + usedLen;
-
-    if (*ptr == '\0')
+    const Item &item = m_Blocks.at(index);
+    if (item.deleted)
     {
         return std::make_pair(nullptr, 0);
     }
 
-    size_t len = 0;
-    if (m_Blocks.size() > index + 1)
-    {
-        len = m_Blocks.at(index + 1) - usedLen;
-    }
-    else
-    {
-        len = m_Capacity - usedLen;
-    }
-
-    return std::make_pair(ptr, len);
+    return std::make_pair(m_Mem + item.offset, item.length);
 }
 
 void MemBlock::Reset()
 {
-    ::memset(m_Mem, 0, m_Capacity);
+    // 只重置使用量，不清零内存
     m_CurrPtr = m_Mem;
     m_UsedSize = 0;
     m_Blocks.clear();
@@ -74,23 +62,10 @@ void MemBlock::Reset()
 
 void MemBlock::Delete(int index)
 {
-    size_t usedLen = m_Blocks.at(index);
-    char *ptr = m_Mem + usedLen;
-
-    size_t len = 0;
-    if (m_Blocks.size() > index + 1)
-    {
-        len = m_Blocks.at(index + 1) - usedLen;
-    }
-    else
-    {
-        len = m_Capacity - usedLen;
-    }
-
-    ::memset(ptr, 0, len);
+    m_Blocks.at(index).deleted = true;
 }
 
 size_t MemBlock::LeftSize() const
 {
     return m_Capacity - m_UsedSize;
-}
\ No newline at end of file
+}
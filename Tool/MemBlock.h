@@ -3,6 +3,7 @@
 /**
  * @brief 内存块管理，内存长度固定
  * 只支持添加数据，查询数据以及删除和重置数据，不支持修改
+ * 每条数据记录自身的偏移和长度，重置和删除都不需要清零内存
  */
 
 #include <cstring>
@@ -20,11 +21,15 @@ public:
     /**向缓冲区尾部加入一块数据
      * @param pData 加入数据的指针
      * @param nDataLen 加入数据的长度
-     * @return 对应内存块存储的索引位置
+     * @param index 输出，对应内存块存储的索引位置
+     * @return 剩余空间不足时返回false，不修改内存块
      */
-    int PushBack(const char *pData, size_t nDataLen);
+    bool PushBack(const char *pData, size_t nDataLen, int &index);
 
-    std::pair<char *, size_t> Get(int index);
+    /**获取数据
+     * @return 数据指针及长度，已删除的数据返回 {nullptr, 0}
+     */
+    std::pair<const char *, size_t> Get(int index) const;
 
     void Delete(int index);
 
@@ -32,6 +37,9 @@ public:
 
     size_t LeftSize() const;
 
+    // 预留数据索引，本块预期存放count条数据
+    void Reserve(size_t count) { m_Blocks.reserve(count); }
+
 private:
     char *m_Mem = nullptr;
     char *m_CurrPtr = nullptr;
@@ -39,6 +47,12 @@ private:
     const size_t m_Capacity;
     size_t m_UsedSize{0};
 
-    // 标识不同内存块的长度
-    std::vector<size_t> m_Blocks;
-};
\ No newline at end of file
+    // 每块数据的位置、长度及删除标记
+    struct Item
+    {
+        size_t offset;
+        size_t length;
+        bool deleted;
+    };
+    std::vector<Item> m_Blocks;
+};
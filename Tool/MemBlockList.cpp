@@ -1,5 +1,8 @@
 #include "MemBlockList.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 MemBlockList::MemBlockList(size_t blockCapacity)
     : m_BlockCapacity(blockCapacity)
 {
@@ -7,47 +10,50 @@ MemBlockList::MemBlockList(size_t blockCapacity)
 
 void MemBlockList::PushData(const char *data, size_t datalen)
 {
-    if (m_BlockWithIndexs.empty())
+    // 记录不跨块存放：从当前块向后找放得下的块，都放不下时新分配一块，
+    // 超过块容量的记录单独占用一块不小于其长度的内存
+    size_t memIndex = m_BlockWithIndexs.empty() ? 0 : m_BlockWithIndexs.back().first;
+    while (memIndex < m_BlockPool.size() && m_BlockPool[memIndex]->LeftSize() < datalen)
     {
-        if (m_BlockPool.empty())
-        {
-            AllocateMem();
-        }
-
-        auto &memblock = m_BlockPool.front();
-        if (datalen <= memblock->LeftSize())
-        {
-            m_BlockWithIndexs.emplace_back(std::make_pair(0, memblock->PushBack(data, datalen)));
-            return;
-        }
+        ++memIndex;
     }
-
-    auto memIndex = m_BlockWithIndexs.back().first;
-    auto &memblock = m_BlockPool.at(memIndex);
-    if (memblock->LeftSize() >= datalen)
+    if (memIndex == m_BlockPool.size())
     {
-        m_BlockWithIndexs.emplace_back(std::make_pair(memIndex, memblock->PushBack(data, datalen)));
+        AllocateMem(std::max(datalen, m_BlockCapacity));
     }
-    else
+
+    PushToBlock(memIndex, data, datalen);
+}
+
+void MemBlockList::PushToBlock(size_t memIndex, const char *data, size_t datalen)
+{
+    int index = 0;
+    if (!m_BlockPool.at(memIndex)->PushBack(data, datalen, index))
     {
-        // 获取下一段内存
-        if (m_BlockPool.size() - 1 < memIndex + 1)
-        {
-            AllocateMem();
-        }
-        auto &newMemblock = m_BlockPool.at(memIndex + 1);
-        m_BlockWithIndexs.emplace_back(std::make_pair(memIndex + 1, newMemblock->PushBack(data, datalen)));
+        throw std::length_error("[MemBlockList]data is larger than the memory block..");
     }
+
+    m_BlockWithIndexs.emplace_back(memIndex, index);
+    m_DataSize += datalen;
 }
 
-void MemBlockList::AllocateMem()
+void MemBlockList::AllocateMem(size_t capacity)
 {
-    m_BlockPool.emplace_back(std::make_unique<MemBlock>(m_BlockCapacity));
+    m_BlockPool.emplace_back(std::make_unique<MemBlock>(capacity));
+}
+
+void MemBlockList::Delete(size_t index)
+{
+    const auto &item = m_BlockWithIndexs.at(index);
+    auto &memblock = m_BlockPool[item.first];
+    m_DataSize -= memblock->Get(item.second).second;
+    memblock->Delete(item.second);
 }
 
 void MemBlockList::Reset()
 {
     m_BlockWithIndexs.clear();
+    m_DataSize = 0;
 
     for (auto &memblock : m_BlockPool)
     {
@@ -55,16 +61,36 @@ void MemBlockList::Reset()
     }
 }
 
-std::vector<std::string> MemBlockList::Traverse()
+void MemBlockList::Reserve(size_t count, size_t totalLen)
 {
-    std::vector<std::string> results;
+    m_BlockWithIndexs.reserve(count);
 
-    for (const auto &item : m_BlockWithIndexs)
+    // 记录不跨块存放，按块容量向上取整
+    size_t blockCount = (totalLen + m_BlockCapacity - 1) / m_BlockCapacity;
+    while (m_BlockPool.size() < blockCount)
     {
-        auto dst = m_BlockPool[item.first]->Get(item.second);
+        AllocateMem(m_BlockCapacity);
+    }
 
-        results.emplace_back(std::string((const char *)dst.first, dst.second));
+    // 每块的数据索引按平均条数预留，多留1/4应对长度波动
+    if (blockCount > 0)
+    {
+        size_t perBlock = (count + blockCount - 1) / blockCount;
+        perBlock += perBlock / 4 + 1;
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            m_BlockPool[i]->Reserve(perBlock);
+        }
     }
+}
+
+std::vector<std::string> MemBlockList::Traverse() const
+{
+    std::vector<std::string> results;
+    results.reserve(m_BlockWithIndexs.size());
+
+    Traverse([&results](const char *data, size_t len)
+             { results.emplace_back(data, len); });
 
     return results;
 }
\ No newline at end of file
@@ -21,13 +21,49 @@ public:
     MemBlockList(MemBlockList &) = delete;
     MemBlockList &operator=(MemBlockList &) = delete;
 
+    /// @brief 添加一条数据，超过块容量的数据单独分配一块
     void PushData(const char *data, size_t datalen);
 
-    // void Deallocate(char *ptr);
+    /// @brief 删除第index条数据，只做标记，不移动其他数据
+    void Delete(size_t index);
 
     void Reset();
 
-    std::vector<std::string> Traverse();
+    /// @brief 预留内存块和记录索引
+    /// @param count 预期记录数
+    /// @param totalLen 预期的数据总长度
+    void Reserve(size_t count, size_t totalLen);
+
+    /// @brief 按添加顺序遍历数据，不拷贝
+    /// @param fn 回调 fn(const char *data, size_t len)，已删除的数据跳过
+    template <class Fn>
+    void Traverse(Fn &&fn) const
+    {
+        for (const auto &item : m_BlockWithIndexs)
+        {
+            auto dst = m_BlockPool[item.first]->Get(item.second);
+            if (dst.first != nullptr)
+            {
+                fn(dst.first, dst.second);
+            }
+        }
+    }
+
+    /// @brief 拷贝出所有数据
+    std::vector<std::string> Traverse() const;
+
+    /// @brief 获取第index条数据，不拷贝；已删除的数据返回 {nullptr, 0}
+    std::pair<const char *, size_t> Get(size_t index) const
+    {
+        const auto &item = m_BlockWithIndexs.at(index);
+        return m_BlockPool[item.first]->Get(item.second);
+    }
+
+    /// @brief 数据条数，含已删除的数据
+    size_t Count() const { return m_BlockWithIndexs.size(); }
+
+    /// @brief 数据总长度，不含已删除的数据
+    size_t DataSize() const { return m_DataSize; }
 
 private:
     const size_t m_BlockCapacity;
@@ -38,6 +74,11 @@ private:
     using BlockItemType = std::pair<size_t, size_t>;
     std::vector<BlockItemType> m_BlockWithIndexs;
 
+    size_t m_DataSize{0};
+
 private:
-    void AllocateMem();
+    void AllocateMem(size_t capacity);
+
+    // 存入第memIndex块并记录位置，放不下时抛出std::length_error，不记录该数据
+    void PushToBlock(size_t memIndex, const char *data, size_t datalen);
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*
+ * @Description: 启动预热，按预期负载提前分配并预取缓存，避免重启后前几百个请求逐档扩容
+ * @Author: yubo
+ * @Date: 2025-02-10
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+// 预期负载
+struct WarmUpProfile
+{
+    size_t objects = 1;        // 需要预热的对象个数
+    size_t records = 0;        // 单个应答的预期记录数
+    size_t avgRecordBytes = 0; // 单条记录的平均字节数
+};
+
+// 预热结果
+struct WarmUpReport
+{
+    size_t objects = 0;       // 实际预热的对象个数
+    size_t reservedBytes = 0; // 预留的缓存总字节数
+    long long elapsedUs = 0;  // 预热耗时(微秒)
+};
+
+namespace warmup
+{
+    inline long long ElapsedUs(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - begin)
+            .count();
+    }
+
+    template <class T>
+    T &Deref(T &obj) { return obj; }
+
+    template <class T>
+    T &Deref(T *obj) { return *obj; }
+
+    template <class T>
+    T &Deref(std::unique_ptr<T> &obj) { return *obj; }
+
+    template <class T>
+    T &Deref(std::shared_ptr<T> &obj) { return *obj; }
+
+    /**
+     * @brief 预热对象缓存中的一组对象，对象需提供 WarmUpReport WarmUp(const WarmUpProfile &)
+     * 元素可以是对象本身或指向对象的(智能)指针，最多预热 profile.objects 个
+     */
+    template <class Iter>
+    WarmUpReport WarmUpObjects(Iter first, Iter last, const WarmUpProfile &profile)
+    {
+        auto begin = std::chrono::steady_clock::now();
+
+        WarmUpReport report;
+        for (; first != last && report.objects < profile.objects; ++first)
+        {
+            report.reservedBytes += Deref(*first).WarmUp(profile).reservedBytes;
+            ++report.objects;
+        }
+
+        report.elapsedUs = ElapsedUs(begin);
+        return report;
+    }
+}